@@ -1,5 +1,6 @@
 TEMPLATE = app
 
+CONFIG += c++11
 QMAKE_CXXFLAGS += -fopenmp
 LIBS += -fopenmp
 
@@ -9,13 +10,25 @@ LIBS += -fopenmp
 #QMAKE_CXXFLAGS += -pg
 #QMAKE_LFLAGS += -pg
 
+# Builds the patch computations' exp and log10 on libm instead of the PatchMath
+# kernels, to compare a run's results against libm's.
+#DEFINES += PATCH_MATH_LIBM
+
 SOURCES += model/carbonflowmap.cpp \
     model/carbonsources.cpp \
     model/configuration.cpp \
+    model/dischargeschedule.cpp \
+    model/flowkernel.cpp \
+    model/flowmapcache.cpp \
+    model/flowoperator.cpp \
     model/hydrofile.cpp \
     model/hydrofiledict.cpp \    
+    model/hydrogeometry.cpp \
+    model/hydrotransition.cpp \
     model/patchcollection.cpp \
     model/patchcomputation.cpp \    
+    model/patchhydrodata.cpp \
+    model/patchmath.cpp \
     model/reducedgrid.cpp \
     model/river.cpp \
     model/riveriofile.cpp \
@@ -27,18 +40,26 @@ HEADERS  +=  model/carbonflowmap.h \
     model/carbonsources.h \
     model/configuration.h \
     model/constants.h \
-    model/flowdata.h \
+    model/dischargeschedule.h \
+    model/flowkernel.h \
+    model/flowmapcache.h \
+    model/flowoperator.h \
     model/grid.h \
     model/hydrodata.h \
     model/hydrofile.h \
     model/hydrofiledict.h \
+    model/hydrogeometry.h \
+    model/hydrotransition.h \
     model/patchcollection.h \
     model/patchcomputation.h \
+    model/patchhydrodata.h \
+    model/patchmath.h \
     model/reducedgrid.h \
     model/river.h \
     model/riveriofile.h \
     model/rivermodel.h \
     model/statistics.h \
+    model/stockview.h \
     model/status.h \
     model/utility.h
 
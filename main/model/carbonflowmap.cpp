@@ -1,5 +1,6 @@
 #include "carbonflowmap.h"
 
+#include <cstring>
 #include <iostream>
 using std::cout;
 using std::endl;
@@ -7,28 +8,104 @@ using std::swap;
 
 CarbonFlowMap::CarbonFlowMap() {
     initialized = false;
+    trimMassFraction = 0.0;
+    totalMass = 0.0;
+    trimmedMass = 0.0;
+    keptMass = 0.0;
+    sourceData.totalSources = 0;
+    sourceData.offsets = NULL;
+    sourceData.sizes = NULL;
+    sourceData.x = NULL;
+    sourceData.y = NULL;
+    sourceData.amount = NULL;
 }
 
-CarbonFlowMap::CarbonFlowMap(HydroFile * newHydroFile, int numIterations) {
+CarbonFlowMap::CarbonFlowMap(HydroFile * newHydroFile, int numIterations, double newTrimMassFraction) {
     hydroFile = newHydroFile;
     iterations = numIterations;
+    trimMassFraction = newTrimMassFraction;
 
-    Grid<CarbonSourceCollection> * source = new Grid<CarbonSourceCollection>(hydroFile->getMapWidth(), hydroFile->getMapHeight());
-    Grid<CarbonSourceCollection> * dest = new Grid<CarbonSourceCollection>(hydroFile->getMapWidth(), hydroFile->getMapHeight());
+    int width = hydroFile->getMapWidth();
+    int height = hydroFile->getMapHeight();
 
-    //We initialize dest because it will become the source after the swap in for loop.
-    initializeCarbonCollection(*dest);
+    //Number the water cells so that everything below works on dense arrays
+    Grid<int> cellIndex(width, height);
+    QVector<int> cellX;
+    QVector<int> cellY;
+    for(int x = 0; x < width; x++) {
+        for(int y = 0; y < height; y++) {
+            if(hydroFile->patchExists(x,y)) {
+                cellIndex(x,y) = cellX.size();
+                cellX.append(x);
+                cellY.append(y);
+            } else {
+                cellIndex(x,y) = -1;
+            }
+        }
+    }
+    int cells = cellX.size();
+
+    /*
+     * One iteration of flow, raised to the number of iterations by repeated squaring:
+     * T^iterations is the product of T, T^2, T^4 ... for the bits set in iterations.
+     *
+     * Input cells start every iteration with the carbon they had before any flow, which
+     * is not a power of a matrix over the cells alone.  So T works on the cells followed
+     * by a copy of their starting carbon that never changes (see buildStencil), and the
+     * two halves are added back together at the end.
+     */
+    CellSources * power = new CellSources;
+    CellSources * dest = new CellSources;
+    CellSources * temp = new CellSources;
+    buildStencil(cellIndex, cellX, cellY, *power);
+
+    //Before any flow every cell only has its own carbon
+    dest->offsets.resize(2 * cells + 1);
+    dest->cells.resize(2 * cells);
+    dest->amounts.resize(2 * cells);
+    for(int i = 0; i < 2 * cells; i++) {
+        dest->offsets[i] = i;
+        dest->cells[i] = i;
+        dest->amounts[i] = 1.0;
+    }
+    dest->offsets[2 * cells] = 2 * cells;
 
-    for(int i = 0; i < iterations; i++){
-        swap(source, dest);
-        //We need a blank destination grid
-        for(unsigned int i = 0; i < dest->getArraySize(); i++){
-            (*dest)(i) = CarbonSourceCollection();
+    QVector<PullScratch> scratch(omp_get_max_threads());
+    for(int t = 0; t < scratch.size(); t++) {
+        scratch[t].sums.resize(2 * cells);
+        scratch[t].lastCell.fill(-1, 2 * cells);
+    }
+
+    for(int remaining = iterations; remaining > 0; remaining >>= 1) {
+        if(remaining & 1) {
+            multiplySources(*power, *dest, *temp, PRECOMPUTED_FLOW_PRODUCT_TRIM_THRESHOLD, scratch);
+            swap(dest, temp);
         }
-        pushCarbon(*source, *dest);
+        if(remaining > 1) {
+            multiplySources(*power, *power, *temp, PRECOMPUTED_FLOW_PRODUCT_TRIM_THRESHOLD, scratch);
+            swap(power, temp);
+        }
+    }
+
+    //Fold the starting carbon half back onto the cells it is a copy of
+    CellSources * fold = power;
+    fold->offsets.resize(2 * cells + 1);
+    fold->cells.resize(2 * cells);
+    fold->amounts.resize(2 * cells);
+    for(int i = 0; i < 2 * cells; i++) {
+        fold->offsets[i] = i;
+        fold->cells[i] = i % cells;
+        fold->amounts[i] = 1.0;
     }
+    fold->offsets[2 * cells] = 2 * cells;
+
+    multiplySources(*dest, *fold, *temp, PRECOMPUTED_FLOW_PRODUCT_TRIM_THRESHOLD, scratch);
+    swap(dest, temp);
 
-    delete source;
+    trimSources(*dest, cells);
+
+    delete power;
+    delete temp;
 
     /*
      * At this point we have data on where each cell gets its carbon from in the specified
@@ -36,42 +113,35 @@ CarbonFlowMap::CarbonFlowMap(HydroFile * newHydroFile, int numIterations) {
      * and so it could be eventually used with OpenCl
      */
 
-    int totalSources = 0;
-    for(unsigned int x = 0; x < dest->getWidth(); x++) {
-        for(unsigned int y = 0; y < dest->getHeight(); y++) {
-            if(hydroFile->patchExists(x,y)){
-                (*dest)(x,y).trim(PRECOMPUTED_FLOW_TRIM_THRESHOLD);
-                totalSources += (*dest)(x,y).getSources()->size();
-            }
-        }
-    }
+    int totalSources = dest->offsets[cells];
 
     sourceData.totalSources = totalSources;
-    sourceData.sizes = new Grid<int>(hydroFile->getMapWidth(), hydroFile->getMapHeight());
-    sourceData.offsets = new Grid<int>(hydroFile->getMapWidth(), hydroFile->getMapHeight());
+    sourceData.sizes = new Grid<int>(width, height);
+    sourceData.offsets = new Grid<int>(width, height);
     sourceData.x = new int[totalSources];
     sourceData.y = new int[totalSources];
     sourceData.amount = new double[totalSources];
 
-
-
+    //Water cells are numbered in the same x then y order used here
     int currOffset = 0;
-    for(unsigned int x = 0; x < dest->getWidth(); x++) {
-        for(unsigned int y = 0; y < dest->getHeight(); y++) {
-            if(hydroFile->patchExists(x,y)){
-
-                const QVector<CarbonSource> * sources = (*dest)(x,y).getSources();
-
-                (*sourceData.offsets)(x,y) = currOffset;
-                (*sourceData.sizes)(x,y) = sources->size();
-                for(int i = 0; i < sources->size(); i++) {
-                    CarbonSource source = (*sources)[i];
-                    sourceData.x[currOffset + i] = source.x;
-                    sourceData.y[currOffset + i] = source.y;
-                    sourceData.amount[currOffset + i] = source.amount;
-                }
-                currOffset += sources->size();
+    for(int x = 0; x < width; x++) {
+        for(int y = 0; y < height; y++) {
+            (*sourceData.offsets)(x,y) = currOffset;
+            (*sourceData.sizes)(x,y) = 0;
+
+            int cell = cellIndex(x,y);
+            if(cell < 0) {
+                continue;
             }
+
+            for(int entry = dest->offsets[cell]; entry < dest->offsets[cell + 1]; entry++) {
+                int sourceCell = dest->cells[entry];
+                sourceData.x[currOffset] = cellX[sourceCell];
+                sourceData.y[currOffset] = cellY[sourceCell];
+                sourceData.amount[currOffset] = dest->amounts[entry];
+                currOffset++;
+            }
+            (*sourceData.sizes)(x,y) = currOffset - (*sourceData.offsets)(x,y);
         }
     }
 
@@ -83,6 +153,10 @@ CarbonFlowMap::CarbonFlowMap(const CarbonFlowMap &other) {
     copy(other);
 }
 
+CarbonFlowMap::CarbonFlowMap(CarbonFlowMap && other) {
+    move(other);
+}
+
 CarbonFlowMap::~CarbonFlowMap() {
     clear();
 }
@@ -95,60 +169,318 @@ CarbonFlowMap & CarbonFlowMap::operator=(const CarbonFlowMap & rhs) {
     return *this;
 }
 
+CarbonFlowMap & CarbonFlowMap::operator=(CarbonFlowMap && rhs) {
+    if(this != &rhs) {
+        clear();
+        move(rhs);
+    }
+    return *this;
+}
+
 
 const SourceArrays CarbonFlowMap::getSourceArrays() const {
     return sourceData;
 }
 
-void CarbonFlowMap::initializeCarbonCollection(Grid<CarbonSourceCollection> & sources){
-    for(int i = 0; i < hydroFile->getMapWidth(); i++){
-        for( int j = 0; j < hydroFile->getMapHeight(); j++){
-            sources(i,j) = CarbonSourceCollection(i,j);
-        }
+double CarbonFlowMap::getTotalMass() const {
+    return totalMass;
+}
+
+double CarbonFlowMap::getTrimmedMass() const {
+    return trimmedMass;
+}
+
+double CarbonFlowMap::getLostMass() const {
+    return totalMass - keptMass;
+}
+
+size_t CarbonFlowMap::getBytes() const {
+    if(!initialized) {
+        return 0;
     }
+
+    size_t gridBytes = 2 * sizeof(int) * (size_t)sourceData.offsets->getWidth() * sourceData.offsets->getHeight();
+    return gridBytes + (2 * sizeof(int) + sizeof(double)) * (size_t)sourceData.totalSources;
 }
 
-void CarbonFlowMap::pushCarbon(
-    Grid<CarbonSourceCollection> & source,
-    Grid<CarbonSourceCollection> & dest)
+void CarbonFlowMap::buildStencil(const Grid<int> & cellIndex, const QVector<int> & cellX,
+                                 const QVector<int> & cellY, CellSources & stencil)
 {
+    int cells = cellX.size();
+    int width = hydroFile->getMapWidth();
+    int height = hydroFile->getMapHeight();
+
+    //The hydromap numbers its water cells in the same x then y order used here
+    const float * hydroFlowVectors = hydroFile->getFlowVectors();
+    const unsigned char * ioFlags = hydroFile->getIOFlags();
+    QVector<QVector2D> flowVectors(cells);
+    QVector<bool> isInputCell(cells);
+    QVector<bool> isOutputCell(cells);
+    for(int i = 0; i < cells; i++) {
+        flowVectors[i] = QVector2D(hydroFlowVectors[2 * i], hydroFlowVectors[2 * i + 1]);
+        isInputCell[i] = (ioFlags[i] & HYDRO_FILE_INPUT) != 0;
+        isOutputCell[i] = (ioFlags[i] & HYDRO_FILE_OUTPUT) != 0;
+    }
 
-    for( int x = 0; x < hydroFile->getMapWidth(); x++) {
-        for( int y = 0; y < hydroFile->getMapHeight(); y++) {
-            if(hydroFile->patchExists(x,y)) {
-                QVector<CarbonSource> * targets = getFlowTargets(x,y);
-                double carbonPushedToOtherWaterPatches = 0.0;
+    //Where each cell pushes its carbon in one iteration, at most four targets plus the
+    //carbon that stays put.
+    QVector<int> pushCells(5 * cells);
+    QVector<double> pushAmounts(5 * cells);
+    QVector<int> pushCount(cells);
+
+    #pragma omp parallel for
+    for(int i = 0; i < cells; i++) {
+        CarbonSource targets[4];
+        int numTargets = getFlowTargets(cellX[i], cellY[i], flowVectors[i], isOutputCell[i], targets);
+
+        double carbonPushedToOtherWaterPatches = 0.0;
+        int count = 0;
+        for(int t = 0; t < numTargets; t++) {
+            const CarbonSource & target = targets[t];
+            carbonPushedToOtherWaterPatches += target.amount;
+
+            //Output cells also push carbon off the map, which leaves the river
+            if(target.x >= 0 && target.x < width && target.y >= 0 && target.y < height
+                    && cellIndex(target.x, target.y) >= 0)
+            {
+                pushCells[5 * i + count] = cellIndex(target.x, target.y);
+                pushAmounts[5 * i + count] = target.amount;
+                count++;
+            }
+        }
+
+        pushCells[5 * i + count] = i;
+        pushAmounts[5 * i + count] = 1.0 - carbonPushedToOtherWaterPatches;
+        count++;
 
-                for(int i = 0; i < targets->size(); i++){
-                    CarbonSource carbonTarget = (*targets)[i];
-                    carbonPushedToOtherWaterPatches += carbonTarget.amount;
+        pushCount[i] = count;
+    }
 
-                    if(hydroFile->patchExists(carbonTarget.x, carbonTarget.y)) {
-                        QVector<CarbonSource> carbonPushed = source(x,y).getSourcesPercentage(carbonTarget.amount);
-                        dest(carbonTarget.x, carbonTarget.y).addSources(carbonPushed);
+    /*
+     * Turn the pushes around so that each cell lists what it pulls.
+     *
+     * Input cells keep 100% of their own carbon every iteration.  Cells used to be pushed
+     * one at a time in x then y order and an input cell's collection was reset right after
+     * its own push to the carbon it had before any flow.  So it still received carbon from
+     * cells pushed after it (higher cell numbers) but not from cells pushed before it.
+     *
+     * We keep that behavior.  Rows cells to 2 * cells - 1 hold each cell's starting carbon
+     * and only ever pull from themselves.  An input cell pulls all of its starting carbon
+     * from there plus the pushes from later cells.
+     */
+    stencil.offsets.fill(0, 2 * cells + 1);
+    for(int i = 0; i < cells; i++) {
+        if(isInputCell[i]) {
+            stencil.offsets[i + 1]++;
+        }
+        for(int t = 0; t < pushCount[i]; t++) {
+            int target = pushCells[5 * i + t];
+            if(!isInputCell[target] || i > target) {
+                stencil.offsets[target + 1]++;
+            }
+        }
+        stencil.offsets[cells + i + 1]++;
+    }
+    for(int i = 0; i < 2 * cells; i++) {
+        stencil.offsets[i + 1] += stencil.offsets[i];
+    }
+
+    stencil.cells.resize(stencil.offsets[2 * cells]);
+    stencil.amounts.resize(stencil.offsets[2 * cells]);
+    QVector<int> next = stencil.offsets;
+    for(int i = 0; i < cells; i++) {
+        for(int t = 0; t < pushCount[i]; t++) {
+            int target = pushCells[5 * i + t];
+            if(!isInputCell[target] || i > target) {
+                stencil.cells[next[target]] = i;
+                stencil.amounts[next[target]] = pushAmounts[5 * i + t];
+                next[target]++;
+            }
+        }
+    }
+    for(int i = 0; i < cells; i++) {
+        if(isInputCell[i]) {
+            stencil.cells[next[i]] = cells + i;
+            stencil.amounts[next[i]] = 1.0;
+            next[i]++;
+        }
+        stencil.cells[next[cells + i]] = cells + i;
+        stencil.amounts[next[cells + i]] = 1.0;
+    }
+}
+
+void CarbonFlowMap::multiplySources(const CellSources & stencil, const CellSources & source,
+                                    CellSources & dest, double trimThreshold,
+                                    QVector<PullScratch> & scratch)
+{
+    int cells = stencil.offsets.size() - 1;
+    dest.offsets.resize(cells + 1);
+    dest.offsets[0] = 0;
+
+    #pragma omp parallel
+    {
+        int thread = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        int begin = (long long)cells * thread / threads;
+        int end = (long long)cells * (thread + 1) / threads;
+
+        PullScratch & local = scratch[thread];
+        local.cells.resize(0);
+        local.amounts.resize(0);
+
+        for(int cell = begin; cell < end; cell++) {
+            local.touched.resize(0);
+
+            //cell pulls from stencilCell, which in turn pulled from sourceCell
+            for(int entry = stencil.offsets[cell]; entry < stencil.offsets[cell + 1]; entry++) {
+                int stencilCell = stencil.cells[entry];
+                double amount = stencil.amounts[entry];
+
+                for(int sourceEntry = source.offsets[stencilCell]; sourceEntry < source.offsets[stencilCell + 1]; sourceEntry++) {
+                    int sourceCell = source.cells[sourceEntry];
+                    if(local.lastCell[sourceCell] != cell) {
+                        local.lastCell[sourceCell] = cell;
+                        local.sums[sourceCell] = 0.0;
+                        local.touched.append(sourceCell);
                     }
+                    local.sums[sourceCell] += source.amounts[sourceEntry] * amount;
                 }
+            }
 
-                double percentStationaryCarbon = 1.0 - carbonPushedToOtherWaterPatches;
-                dest(x,y).addSources( source(x,y).getSourcesPercentage(percentStationaryCarbon) );
-
-                //Input cells do not get carbon from other cells.  They keep 100% of their carbon per iteration.
-                if(hydroFile->isInput(x,y)){
-                    dest(x,y) = CarbonSourceCollection(x,y);
+            std::sort(local.touched.begin(), local.touched.end());
+            int kept = 0;
+            for(int t = 0; t < local.touched.size(); t++) {
+                int sourceCell = local.touched[t];
+                local.lastCell[sourceCell] = -1;
+                if(local.sums[sourceCell] > trimThreshold) {
+                    local.cells.append(sourceCell);
+                    local.amounts.append(local.sums[sourceCell]);
+                    kept++;
                 }
+            }
+            dest.offsets[cell + 1] = kept;
+        }
 
-                //TODO: Avoid new and deleting over and over...
-                delete targets;
+        #pragma omp barrier
+        #pragma omp single
+        {
+            for(int cell = 0; cell < cells; cell++) {
+                dest.offsets[cell + 1] += dest.offsets[cell];
             }
+            dest.cells.resize(dest.offsets[cells]);
+            dest.amounts.resize(dest.offsets[cells]);
+        }
+
+        //Each thread's block of cells is contiguous so its sources are too
+        int destOffset = dest.offsets[begin];
+        for(int entry = 0; entry < local.cells.size(); entry++) {
+            dest.cells[destOffset + entry] = local.cells[entry];
+            dest.amounts[destOffset + entry] = local.amounts[entry];
         }
     }
 }
 
-QVector<CarbonSource> * CarbonFlowMap::getFlowTargets(int i, int j){
-    QVector<CarbonSource> * targets = new QVector<CarbonSource>();
-    QVector2D flowVector = hydroFile->getVector(i,j);
+namespace {
+    //Orders source entries from the most carbon to the least
+    struct LargerAmount {
+        const QVector<double> & amounts;
+        LargerAmount(const QVector<double> & newAmounts) : amounts(newAmounts) {}
+        bool operator()(int a, int b) const {
+            return amounts[a] > amounts[b] || (amounts[a] == amounts[b] && a < b);
+        }
+    };
+}
 
-    bool isOutputCell = hydroFile->isOutput(i,j);
+void CarbonFlowMap::trimSources(CellSources & sources, int cells) {
+    totalMass = 0.0;
+    trimmedMass = 0.0;
+    keptMass = 0.0;
+
+    //Pick each cell's sources, totalling how much of every source's carbon flows into
+    //all cells and how much of it through the kept entries
+    QVector<bool> keep(sources.offsets[cells], false);
+    QVector<double> sourceMass(cells, 0.0);
+    QVector<double> sourceKept(cells, 0.0);
+    QVector<int> order;
+    for(int cell = 0; cell < cells; cell++) {
+        int begin = sources.offsets[cell];
+        int end = sources.offsets[cell + 1];
+
+        double rowMass = 0.0;
+        for(int entry = begin; entry < end; entry++) {
+            rowMass += sources.amounts[entry];
+        }
+
+        double rowKept = 0.0;
+        if(trimMassFraction > 0.0) {
+            //Keep the largest sources until they cover the fraction of the cell's carbon
+            order.resize(end - begin);
+            for(int entry = begin; entry < end; entry++) {
+                order[entry - begin] = entry;
+            }
+            std::sort(order.begin(), order.end(), LargerAmount(sources.amounts));
+            for(int i = 0; i < order.size() && rowKept < trimMassFraction * rowMass; i++) {
+                keep[order[i]] = true;
+                rowKept += sources.amounts[order[i]];
+            }
+        } else {
+            for(int entry = begin; entry < end; entry++) {
+                if(sources.amounts[entry] > PRECOMPUTED_FLOW_TRIM_THRESHOLD) {
+                    keep[entry] = true;
+                    rowKept += sources.amounts[entry];
+                }
+            }
+        }
+
+        for(int entry = begin; entry < end; entry++) {
+            sourceMass[sources.cells[entry]] += sources.amounts[entry];
+            if(keep[entry]) {
+                sourceKept[sources.cells[entry]] += sources.amounts[entry];
+            }
+        }
+
+        totalMass += rowMass;
+        trimmedMass += rowMass - rowKept;
+    }
+
+    /* Adaptive trimming hands the carbon a source lost with its dropped entries to the
+     * cells its kept entries reach, so every source still sends out all of its carbon
+     * whatever the stocks are.  A source with no entry kept anywhere is lost.
+     */
+    QVector<double> scale(cells, 1.0);
+    if(trimMassFraction > 0.0) {
+        for(int source = 0; source < cells; source++) {
+            if(sourceKept[source] > 0.0) {
+                scale[source] = sourceMass[source] / sourceKept[source];
+            }
+        }
+    }
+
+    //Rows are compacted in place, a row never ends up past where it started
+    int currOffset = 0;
+    for(int cell = 0; cell < cells; cell++) {
+        int begin = sources.offsets[cell];
+        int end = sources.offsets[cell + 1];
+        sources.offsets[cell] = currOffset;
+
+        for(int entry = begin; entry < end; entry++) {
+            if(keep[entry]) {
+                int sourceCell = sources.cells[entry];
+                sources.cells[currOffset] = sourceCell;
+                sources.amounts[currOffset] = sources.amounts[entry] * scale[sourceCell];
+                keptMass += sources.amounts[currOffset];
+                currOffset++;
+            }
+        }
+    }
+    sources.offsets.resize(cells + 1);
+    sources.offsets[cells] = currOffset;
+}
+
+int CarbonFlowMap::getFlowTargets(int i, int j, const QVector2D & flowVector, bool isOutputCell,
+                                  CarbonSource * targets) const
+{
+    int numTargets = 0;
 
     int x = i * PATCH_LENGTH;
     int y = j * PATCH_LENGTH;
@@ -202,7 +534,7 @@ QVector<CarbonSource> * CarbonFlowMap::getFlowTargets(int i, int j){
         double targetAreaA = targetWidthA*targetHeightA;
         double percentA = targetAreaA/PATCH_AREA;
         CarbonSource targetA(iA, jA, percentA);
-        targets->append(targetA);
+        targets[numTargets++] = targetA;
     }
 
     //Target B
@@ -212,7 +544,7 @@ QVector<CarbonSource> * CarbonFlowMap::getFlowTargets(int i, int j){
         double targetAreaB = targetWidthB*targetHeightB;
         double percentB = targetAreaB/PATCH_AREA;
         CarbonSource targetB(iB, jB, percentB);
-        targets->append(targetB);
+        targets[numTargets++] = targetB;
     }
 
     //Target C
@@ -222,7 +554,7 @@ QVector<CarbonSource> * CarbonFlowMap::getFlowTargets(int i, int j){
         double targetAreaC = targetWidthC*targetHeightC;
         double percentC = targetAreaC/PATCH_AREA;
         CarbonSource targetC(iC, jC, percentC);
-        targets->append(targetC);
+        targets[numTargets++] = targetC;
     }
 
     //Target D
@@ -232,21 +564,170 @@ QVector<CarbonSource> * CarbonFlowMap::getFlowTargets(int i, int j){
         double targetAreaD = targetWidthD*targetHeightD;
         double percentD = targetAreaD/PATCH_AREA;
         CarbonSource targetD(iD, jD, percentD);
-        targets->append(targetD);
+        targets[numTargets++] = targetD;
+    }
+
+    return numTargets;
+}
+
+namespace {
+    /**
+     * Layout of a saved CarbonFlowMap.  The header is followed by the offsets and sizes
+     * grids, the x and y arrays, padding up to a multiple of 8 bytes and then the amounts.
+     */
+    struct CarbonFlowMapFileHeader {
+        char magic[4];
+        qint32 version;
+        qint32 byteOrder;
+        qint32 width;
+        qint32 height;
+        qint32 iterations;
+        qint32 totalSources;
+        qint32 reserved;
+        double trimThreshold;
+        double trimMassFraction;
+        double totalMass;
+        double trimmedMass;
+        double keptMass;
+    };
+
+    const char CARBON_FLOW_MAP_MAGIC[4] = {'C', 'F', 'M', 'P'};
+    const qint32 CARBON_FLOW_MAP_BYTE_ORDER = 0x01020304;
+
+    qint64 amountsOffset(qint64 cells, qint64 totalSources) {
+        qint64 offset = sizeof(CarbonFlowMapFileHeader) + sizeof(int) * (2 * cells + 2 * totalSources);
+        return (offset + 7) / 8 * 8;
     }
+}
+
+bool CarbonFlowMap::writeFile(const QString & filename) const {
+    if(!initialized) {
+        return false;
+    }
+
+    CarbonFlowMapFileHeader header;
+    memcpy(header.magic, CARBON_FLOW_MAP_MAGIC, sizeof(header.magic));
+    header.version = CARBON_FLOW_MAP_FILE_VERSION;
+    header.byteOrder = CARBON_FLOW_MAP_BYTE_ORDER;
+    header.width = sourceData.offsets->getWidth();
+    header.height = sourceData.offsets->getHeight();
+    header.iterations = iterations;
+    header.totalSources = sourceData.totalSources;
+    header.reserved = 0;
+    header.trimThreshold = PRECOMPUTED_FLOW_TRIM_THRESHOLD;
+    header.trimMassFraction = trimMassFraction;
+    header.totalMass = totalMass;
+    header.trimmedMass = trimmedMass;
+    header.keptMass = keptMass;
+
+    qint64 cells = (qint64)header.width * header.height;
+    qint64 intBytes = sizeof(int) * cells;
+    qint64 sourceBytes = sizeof(int) * (qint64)sourceData.totalSources;
+    qint64 amountBytes = sizeof(double) * (qint64)sourceData.totalSources;
+    qint64 padding = amountsOffset(cells, sourceData.totalSources)
+            - sizeof(header) - 2 * intBytes - 2 * sourceBytes;
+    const char zeros[8] = {0};
+
+    QFile file(filename);
+    if(!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    bool written = file.write((const char *)&header, sizeof(header)) == sizeof(header)
+            && file.write((const char *)sourceData.offsets->getArray(), intBytes) == intBytes
+            && file.write((const char *)sourceData.sizes->getArray(), intBytes) == intBytes
+            && file.write((const char *)sourceData.x, sourceBytes) == sourceBytes
+            && file.write((const char *)sourceData.y, sourceBytes) == sourceBytes
+            && file.write(zeros, padding) == padding
+            && file.write((const char *)sourceData.amount, amountBytes) == amountBytes;
+    file.close();
 
-    return targets;
+    return written && file.error() == QFile::NoError;
+}
+
+bool CarbonFlowMap::mapFile(const QString & filename, HydroFile * newHydroFile, int numIterations,
+                            double newTrimMassFraction)
+{
+    QSharedPointer<QFile> file(new QFile(filename));
+    if(!file->open(QIODevice::ReadOnly) || file->size() < (qint64)sizeof(CarbonFlowMapFileHeader)) {
+        return false;
+    }
+
+    uchar * data = file->map(0, file->size());
+    if(data == NULL) {
+        return false;
+    }
+
+    CarbonFlowMapFileHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    qint64 cells = (qint64)header.width * header.height;
+    bool valid = memcmp(header.magic, CARBON_FLOW_MAP_MAGIC, sizeof(header.magic)) == 0
+            && header.version == CARBON_FLOW_MAP_FILE_VERSION
+            && header.byteOrder == CARBON_FLOW_MAP_BYTE_ORDER
+            && header.width == newHydroFile->getMapWidth()
+            && header.height == newHydroFile->getMapHeight()
+            && header.iterations == numIterations
+            && header.trimThreshold == PRECOMPUTED_FLOW_TRIM_THRESHOLD
+            && header.trimMassFraction == newTrimMassFraction
+            && header.totalSources >= 0
+            && file->size() == amountsOffset(cells, header.totalSources) + (qint64)sizeof(double) * header.totalSources;
+    if(!valid) {
+        return false;
+    }
+
+    clear();
+
+    hydroFile = newHydroFile;
+    iterations = numIterations;
+    trimMassFraction = newTrimMassFraction;
+    totalMass = header.totalMass;
+    trimmedMass = header.trimmedMass;
+    keptMass = header.keptMass;
+
+    const int * grids = (const int *)(data + sizeof(header));
+    sourceData.totalSources = header.totalSources;
+    sourceData.offsets = new Grid<int>(header.width, header.height);
+    sourceData.sizes = new Grid<int>(header.width, header.height);
+    memcpy(sourceData.offsets->getArray(), grids, sizeof(int) * cells);
+    memcpy(sourceData.sizes->getArray(), grids + cells, sizeof(int) * cells);
+
+    //The mapping is read only, the arrays are never written after they are computed
+    sourceData.x = (int *)(grids + 2 * cells);
+    sourceData.y = sourceData.x + header.totalSources;
+    sourceData.amount = (double *)(data + amountsOffset(cells, header.totalSources));
+
+    mappedFile = file;
+    initialized = true;
+    return true;
 }
 
 void CarbonFlowMap::copy(const CarbonFlowMap &other) {
     initialized = other.initialized;
     hydroFile = other.hydroFile;
     iterations = other.iterations;
+    trimMassFraction = other.trimMassFraction;
+    totalMass = other.totalMass;
+    trimmedMass = other.trimmedMass;
+    keptMass = other.keptMass;
+    mappedFile = other.mappedFile;
+
+    if(!initialized) {
+        return;
+    }
 
     sourceData.totalSources = other.sourceData.totalSources;
     sourceData.offsets = new Grid<int>(*other.sourceData.offsets);
     sourceData.sizes = new Grid<int>(*other.sourceData.sizes);
 
+    //Mapped data is shared with the other flow map rather than copied
+    if(mappedFile) {
+        sourceData.x = other.sourceData.x;
+        sourceData.y = other.sourceData.y;
+        sourceData.amount = other.sourceData.amount;
+        return;
+    }
+
     sourceData.x = new int[sourceData.totalSources];
     sourceData.y = new int[sourceData.totalSources];
     sourceData.amount = new double[sourceData.totalSources];
@@ -258,17 +739,43 @@ void CarbonFlowMap::copy(const CarbonFlowMap &other) {
     }
 }
 
+void CarbonFlowMap::move(CarbonFlowMap & other) {
+    initialized = other.initialized;
+    hydroFile = other.hydroFile;
+    iterations = other.iterations;
+    trimMassFraction = other.trimMassFraction;
+    totalMass = other.totalMass;
+    trimmedMass = other.trimmedMass;
+    keptMass = other.keptMass;
+    sourceData = other.sourceData;
+    mappedFile = other.mappedFile;
+
+    //The arrays now belong to this flow map
+    other.initialized = false;
+    other.mappedFile.clear();
+    other.sourceData.totalSources = 0;
+    other.sourceData.offsets = NULL;
+    other.sourceData.sizes = NULL;
+    other.sourceData.x = NULL;
+    other.sourceData.y = NULL;
+    other.sourceData.amount = NULL;
+}
+
 void CarbonFlowMap::clear() {
     /* Note: We do not delete hydroFile as that is created/deleted
      * elsewhere and we only point to it.
      */
     if(initialized) {
-        delete [] sourceData.x;
-        delete [] sourceData.y;
-        delete [] sourceData.amount;
+        if(!mappedFile) {
+            delete [] sourceData.x;
+            delete [] sourceData.y;
+            delete [] sourceData.amount;
+        }
         delete sourceData.offsets;
         delete sourceData.sizes;
     }
+    initialized = false;
+    mappedFile.clear();
 }
 
 void CarbonFlowMap::printDebug(){
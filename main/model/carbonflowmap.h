@@ -3,12 +3,21 @@
 
 #include <algorithm>
 #include <cmath>
+#include <omp.h>
+#include <QFile>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <QVector2D>
 
 #include "constants.h"
 #include "hydrofile.h"
 #include "grid.h"
 #include "carbonsources.h"
 
+//Bump whenever the layout of saved CarbonFlowMap files or the way they are computed changes
+#define CARBON_FLOW_MAP_FILE_VERSION 4
+
 struct SourceArrays {
     int totalSources;
     Grid<int> * offsets;
@@ -21,6 +30,28 @@ struct SourceArrays {
     int getSize(int x, int y) {return (*sizes)(x,y); }
 };
 
+/**
+ * @brief Where every water cell gets its carbon from, stored back to back and indexed
+ *        by water cell number rather than by (x,y).  Used while precomputing flows.
+ */
+struct CellSources {
+    QVector<int> offsets;     ///< number of cells + 1 offsets into cells/amounts
+    QVector<int> cells;       ///< water cell number of each source
+    QVector<double> amounts;  ///< fraction of the source's carbon received
+};
+
+/**
+ * @brief Per thread buffers reused by every iteration of the precompute so that the
+ *        inner loops never allocate.
+ */
+struct PullScratch {
+    QVector<double> sums;     ///< dense accumulator, one entry per water cell
+    QVector<int> lastCell;    ///< which destination cell last touched each accumulator entry
+    QVector<int> touched;     ///< accumulator entries used by the current cell
+    QVector<int> cells;       ///< sources produced by this thread's block of cells
+    QVector<double> amounts;
+};
+
 /**
  * @brief The CarbonFlowMap class is used to determine where a cell retrieves its
  *        carbon.  
@@ -35,11 +66,10 @@ struct SourceArrays {
  *        carbon.  For example, if in one iteration of pushing carbon a cell receives 20%
  *        of another cell's carbon, then the carbon flow map would indicate this.  Finally
  *        we can precompute like this for multiple iterations.  The number of iterations that
- *        we can precompute is relatively small because the memory requirements is exponential,
+ *        we can precompute is limited because the number of sources per cell grows with it,
  *        however, even just 4 iterations of precomputation allows us to reduce the number of
- *        iterations of the main flow loop from 60 to 15, which is significant.  An important
- *        thing to note is that the number of iterations must be a factor of 60 and the number
- *        of main flow iterations must be (60 / numPreComputedIterations).
+ *        iterations of the main flow loop from 60 to 15, which is significant.  When the
+ *        number of iterations does not divide 60 a second map covers the minutes left over.
  */
 class CarbonFlowMap {
     public:
@@ -52,14 +82,25 @@ class CarbonFlowMap {
          * @brief Primary construtor that properly initializes object
          * @param hydroFile The hydroFile to do preprocessing on
          * @param iterations The number of iterations to precompute flows.
+         * @param trimMassFraction 0 drops every source at or below PRECOMPUTED_FLOW_TRIM_THRESHOLD.
+         *        Otherwise each cell keeps its largest sources until they cover this fraction
+         *        of its carbon.  The kept entries of each source are scaled up so the source
+         *        still sends out all of its carbon.
          */
-        CarbonFlowMap(HydroFile * hydroFile, int iterations);
+        CarbonFlowMap(HydroFile * hydroFile, int iterations, double trimMassFraction = 0.0);
 
         //Big 3
         CarbonFlowMap(const CarbonFlowMap & other);
         ~CarbonFlowMap();
         CarbonFlowMap & operator=(const CarbonFlowMap & rhs);
 
+        /**
+         * @brief Move construction and assignment take the other flow map's arrays rather
+         *        than copying them and leave it uninitialized
+         */
+        CarbonFlowMap(CarbonFlowMap && other);
+        CarbonFlowMap & operator=(CarbonFlowMap && rhs);
+
         /**
          * @brief Returns the arrays holding the carbonFlowMap's data
          *        Note: This carbonFlowMap should not be deleted while the client holds
@@ -69,6 +110,51 @@ class CarbonFlowMap {
         const SourceArrays getSourceArrays() const;
         void printDebug();
 
+        /**
+         * @brief Returns the carbon flowing into all cells when every cell starts with one
+         *        unit, before trimming
+         */
+        double getTotalMass() const;
+
+        /**
+         * @brief Returns how much of the total mass was in the sources dropped by trimming
+         */
+        double getTrimmedMass() const;
+
+        /**
+         * @brief Returns how much of the total mass is missing from the trimmed flows.  This
+         *        is the trimmed mass unless adaptive trimming gave it back to its sources'
+         *        other entries, then only the carbon of sources with no entry left is lost.
+         */
+        double getLostMass() const;
+
+        /**
+         * @brief Returns the memory held by the flows, including any mapped from a file.
+         *        0 if the flow map is uninitialized.
+         */
+        size_t getBytes() const;
+
+        /**
+         * @brief Saves the precomputed flows so they can later be mapped with mapFile()
+         * @param filename File to write
+         * @return True if the whole file was written
+         */
+        bool writeFile(const QString & filename) const;
+
+        /**
+         * @brief Memory maps flows previously saved with writeFile().  The source arrays
+         *        point straight into the mapping, which is shared by copies of this object
+         *        and released when the last of them is destroyed.
+         * @param filename File to map
+         * @param newHydroFile The hydroFile the flows were computed for
+         * @param numIterations The number of iterations the flows must cover
+         * @param newTrimMassFraction The trimming the flows must have been built with
+         * @return False, leaving this object untouched, if the file is missing, from another
+         *         version or does not match the hydroFile, iterations and trimming.
+         */
+        bool mapFile(const QString & filename, HydroFile * newHydroFile, int numIterations,
+                     double newTrimMassFraction);
+
     private:
         //False if not initialized, true otherwise
         bool initialized;
@@ -77,32 +163,66 @@ class CarbonFlowMap {
         HydroFile * hydroFile;
         //Number of iterations pre-computed
         int iterations;
+        //Fraction of each cell's carbon kept by adaptive trimming, 0 for the fixed threshold
+        double trimMassFraction;
+        //Carbon flowing into all cells before trimming, dropped by trimming and kept after it
+        double totalMass;
+        double trimmedMass;
+        double keptMass;
         //Collection of arrays and grids that store the carbonFlowMap data.
         SourceArrays sourceData;
+        //Set when x, y and amount point into a mapped file rather than arrays we allocated
+        QSharedPointer<QFile> mappedFile;
+
+        /**
+         * @brief Builds the one iteration stencil: for every water cell, the cells it pulls
+         *        carbon from and how much.  This is the transfer matrix for one iteration,
+         *        one row per destination cell followed by one row per cell's starting carbon.
+         * @param cellIndex Water cell number of every (x,y), -1 for land
+         * @param cellX X coordinate of every water cell
+         * @param cellY Y coordinate of every water cell
+         * @param stencil Receives the stencil
+         */
+        void buildStencil(const Grid<int> & cellIndex, const QVector<int> & cellX,
+                          const QVector<int> & cellY, CellSources & stencil);
 
         /**
-         * @brief Initializes all CarbonSourceCollections within the grid passed as parameter
-         * @param source A grid containing uninitialized CarbonSourceCollection Objects
+         * @brief Multiplies two transfer matrices by pulling every cell's sources through
+         *        the stencil, so dest covers the iterations of source followed by those of
+         *        stencil.  Cells are split into one contiguous block per thread.
+         * @param stencil The later iterations
+         * @param source The earlier iterations
+         * @param dest Receives the product, must not be stencil or source
+         * @param trimThreshold Sources with this fraction of carbon or less are dropped
+         * @param scratch One set of buffers per thread
          */
-        void initializeCarbonCollection(Grid<CarbonSourceCollection> & source);
+        void multiplySources(const CellSources & stencil, const CellSources & source,
+                             CellSources & dest, double trimThreshold,
+                             QVector<PullScratch> & scratch);
 
         /**
-         * @brief Precomputes flows for a single iteration
-         * @param source Grid where data is pulled from
-         * @param dest Grid where calculations are placed
+         * @brief Trims the sources of the first cells rows in place and records how much
+         *        carbon was dropped and kept
+         * @param sources Every cell's sources, sorted by source cell
+         * @param cells Number of water cells
          */
-        void pushCarbon(Grid<CarbonSourceCollection> & source, Grid<CarbonSourceCollection> & dest);
+        void trimSources(CellSources & sources, int cells);
 
         /**
-         * @brief Returns a vector of carbonSources that specifiy to where and how much of
-         *        the specified (x,y) cell's carbon will be transfered
+         * @brief Fills targets with where and how much of the specified (x,y) cell's
+         *        carbon will be transfered
          * @param x Source cell's x coord
          * @param y Source cell's y coord
-         * @return A QVector of Carbon sources.
+         * @param flowVector The source cell's flow vector
+         * @param isOutputCell Output cells also push carbon out of the river
+         * @param targets Room for the four possible targets
+         * @return The number of targets filled in
          */
-        QVector<CarbonSource> * getFlowTargets(int x, int y);
+        int getFlowTargets(int x, int y, const QVector2D & flowVector, bool isOutputCell,
+                           CarbonSource * targets) const;
 
         void copy(const CarbonFlowMap &other);
+        void move(CarbonFlowMap & other);
         void clear();
 };
 
@@ -1,4 +1,5 @@
 #include "configuration.h"
+#include "constants.h"
 
 using std::ofstream;
 using std::ifstream;
@@ -105,7 +106,16 @@ Configuration::Configuration() :
     sedconsumerSenescence(-1.0),
     sedconsumerMax(-1.0),
     periAj(-1.0),
-    periGj(-1.0)
+    periGj(-1.0),
+    hourlyFlow(false),
+    flowPrecomputeDepth(ITERATIONS_TO_PRECOMPUTE_FLOWS),
+    flowTrimMassFraction(0.0),
+    compactFlow(false),
+    validateCompactFlow(false),
+    flowMemoryBudget(0),
+    hydroMapDirectory(DEFAULT_HYDRO_MAP_DIRECTORY),
+    saveFluxes(false),
+    validatePatchMath(false)
 {
 
 }
@@ -269,6 +279,21 @@ void Configuration::write(QString const & filename) const
     file << periAj << endl;
     file << periGj << endl;
 
+    file << hourlyFlow << endl;
+    file << flowPrecomputeDepth << endl;
+    file << flowTrimMassFraction << endl;
+
+    file << compactFlow << endl;
+    file << validateCompactFlow << endl;
+
+    file << flowMemoryBudget << endl;
+
+    file << dischargeFile.toStdString().c_str() << endl;
+    file << hydroMapDirectory.toStdString().c_str() << endl;
+
+    file << saveFluxes << endl;
+    file << validatePatchMath << endl;
+
     file.close();
 }
 
@@ -429,6 +454,44 @@ void Configuration::read(QString const & filename)
     periAj = nextFloat(file, str);
     periGj = nextFloat(file, str);
 
+    //Older configuration files end here and leave hourly flow off
+    hourlyFlow = nextBool(file, str);
+
+    //Older configuration files end here and use the default depth
+    flowPrecomputeDepth = nextInt(file, str);
+    if(flowPrecomputeDepth < 1 || flowPrecomputeDepth > FLOW_ITERATIONS_PER_HOUR) {
+        flowPrecomputeDepth = ITERATIONS_TO_PRECOMPUTE_FLOWS;
+    }
+
+    //Older configuration files end here and use the fixed trim threshold
+    flowTrimMassFraction = nextFloat(file, str);
+    if(flowTrimMassFraction < 0.0 || flowTrimMassFraction > 1.0) {
+        flowTrimMassFraction = 0.0;
+    }
+
+    //Older configuration files end here and keep double precision flows
+    compactFlow = nextBool(file, str);
+    validateCompactFlow = nextBool(file, str);
+
+    //Older configuration files end here and keep every hydromap's flows
+    flowMemoryBudget = nextInt(file, str);
+    if(flowMemoryBudget < 0) {
+        flowMemoryBudget = 0;
+    }
+
+    //Older configuration files end here and run the listed hydromaps
+    dischargeFile = QString::fromStdString(nextLine(file, str));
+    hydroMapDirectory = QString::fromStdString(nextLine(file, str));
+    if(hydroMapDirectory.isEmpty()) {
+        hydroMapDirectory = DEFAULT_HYDRO_MAP_DIRECTORY;
+    }
+
+    //Older configuration files end here and only keep the stocks
+    saveFluxes = nextBool(file, str);
+
+    //Older configuration files end here and do not check the patch math
+    validatePatchMath = nextBool(file, str);
+
     file.close();
 }
 
@@ -454,6 +517,9 @@ double Configuration::nextDouble(ifstream & file, string & str)
 
 string & Configuration::nextLine(ifstream & file, string & str) const
 {
-    std::getline(file, str);
+    //Lines past the end of older files read as empty
+    if(!std::getline(file, str)) {
+        str.clear();
+    }
     return str;
 }
@@ -9,6 +9,7 @@
 #include <string>
 
 #define NUM_UNIQUE_HYDRO_MAPS 10
+#define DEFAULT_HYDRO_MAP_DIRECTORY "./data/HydroSets"
 
 class Configuration
 {
@@ -126,6 +127,16 @@ class Configuration
   *     Sedconsumer Max                         (float)
   *     Peri Aj                                 (float)
   *     Peri Gj                                 (float)
+  *     Hourly flow                             (bool)
+  *     Flow precompute depth                   (int)
+  *     Flow trim mass fraction                 (float)
+  *     Compact flow                            (bool)
+  *     Validate compact flow                   (bool)
+  *     Flow memory budget in MB                (int)
+  *     Discharge file                          (char*)
+  *     Hydro map directory                     (char*)
+  *     Save fluxes                             (bool)
+  *     Validate patch math                     (bool)
   */
 
 public:
@@ -275,6 +286,46 @@ public:
     float periAj;
     float periGj;
 
+    // When set each hydromap's flow is composed into a single operator covering
+    // a simulated hour instead of being applied once per precomputed timestep
+    bool hourlyFlow;
+
+    // Number of one minute flow iterations precomputed for each hydromap, 1 to 60.
+    // Deeper precomputes need fewer flows per hour but hold more sources per patch.
+    int flowPrecomputeDepth;
+
+    // When above 0 each patch keeps only the largest precomputed flow sources covering
+    // this fraction of its incoming carbon and scales them up to cover all of it.
+    // 0 drops every source below PRECOMPUTED_FLOW_TRIM_THRESHOLD instead.
+    float flowTrimMassFraction;
+
+    // When set flow operators store their weights as floats, which cuts the memory
+    // streamed per flow.  Sums are still accumulated in double precision.
+    bool compactFlow;
+
+    // When set along with compactFlow each hydromap's compact operators are checked
+    // against the double ones and the differences printed
+    bool validateCompactFlow;
+
+    // Megabytes of precomputed flows and flow operators kept in memory.  The least
+    // recently used hydromaps' flows are released past it.  0 keeps every hydromap's.
+    int flowMemoryBudget;
+
+    // When set the hydromaps and days to run are built from this file of daily discharge
+    // using minFlow and maxFlow, see DischargeSchedule, instead of the ones listed above
+    QString dischargeFile;
+
+    // Directory holding the hydromaps chosen from the discharge file
+    QString hydroMapDirectory;
+
+    // When set every patch's fluxes and limitations are kept each hour and saved with
+    // the map data.  Otherwise only the stocks are kept and the flux arrays never allocated.
+    bool saveFluxes;
+
+    // When set the exp and log10 arguments of each hydromap's patches are run through the
+    // selected PatchMath kernels and the largest differences from libm printed
+    bool validatePatchMath;
+
 private:
     /**
      * @brief Read the next line of the file as a boolean.
@@ -9,10 +9,20 @@
 #define PATCH_LENGTH 30.0
 #define PATCH_AREA (PATCH_LENGTH * PATCH_LENGTH)
 
-//The following constant MUST be a factor of 60
+//The river flows in one minute iterations.  Flows are precomputed for a number of them
+//(the depth, set per run in Configuration) and the result is applied enough times to cover
+//the hour, plus one shorter flow for the minutes left over if the depth does not divide 60.
+#define FLOW_ITERATIONS_PER_HOUR 60
 #define ITERATIONS_TO_PRECOMPUTE_FLOWS 4
-#define ITERATIONS_TO_FLOW_RIVER (60 / ITERATIONS_TO_PRECOMPUTE_FLOWS)
 #define PRECOMPUTED_FLOW_TRIM_THRESHOLD 0.0001
+//Finer trim applied after every product while squaring up to the precomputed flows so
+//that intermediate powers stay sparse without losing sources that survive the final trim
+#define PRECOMPUTED_FLOW_PRODUCT_TRIM_THRESHOLD (PRECOMPUTED_FLOW_TRIM_THRESHOLD / 100)
+
+//Stocks moved by the flow are interleaved per patch in this order.
+//The AVX2 flow kernel holds one patch in a single register so this must stay 4.
+#define FLOW_STOCKS 4
+enum {FLOW_DOC, FLOW_POC, FLOW_PHYTO, FLOW_WATERDECOMP};
 
 //TODO find out if there is a better name for this...
 #define THETA 1.072
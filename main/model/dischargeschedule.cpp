@@ -0,0 +1,92 @@
+#include "dischargeschedule.h"
+
+DischargeSchedule::DischargeSchedule() {
+    days = 0;
+}
+
+DischargeSchedule::DischargeSchedule(const QString & dischargeFilename, const QString & hydroMapDirectory,
+                                     const QVector<int> & minFlow, const QVector<int> & maxFlow)
+{
+    days = 0;
+
+    std::ifstream file(dischargeFilename.toStdString().c_str());
+    std::string str;
+    int lastIndex = -1;
+    while(std::getline(file, str)) {
+        QString line = QString::fromStdString(str).trimmed();
+        if(line.isEmpty()) {
+            continue;
+        }
+
+        //A line that isn't a number would shift every later day, so the whole file is rejected
+        bool ok = false;
+        double discharge = line.toDouble(&ok);
+        int index = ok ? getHydroMapIndex(discharge, minFlow, maxFlow) : -1;
+        if(index < 0) {
+            hydroMaps.clear();
+            daysToRun.clear();
+            days = 0;
+            return;
+        }
+        days++;
+
+        //Days to run are stored in 16 bits, longer stretches are split
+        if(index == lastIndex && daysToRun.last() < std::numeric_limits<uint16_t>::max()) {
+            daysToRun.last()++;
+        } else {
+            hydroMaps.append(getHydroMapFilename(index, hydroMapDirectory));
+            daysToRun.append(1);
+        }
+        lastIndex = index;
+    }
+}
+
+int DischargeSchedule::getHydroMapIndex(double discharge, const QVector<int> & minFlow,
+                                        const QVector<int> & maxFlow)
+{
+    int nearest = -1;
+    double nearestDistance = 0.0;
+    for(int i = 0; i < minFlow.size() && i < maxFlow.size(); i++) {
+        if(minFlow[i] > maxFlow[i]) {
+            continue;
+        }
+
+        double distance = 0.0;
+        if(discharge < minFlow[i]) {
+            distance = minFlow[i] - discharge;
+        } else if(discharge > maxFlow[i]) {
+            distance = discharge - maxFlow[i];
+        }
+
+        if(nearest < 0 || distance < nearestDistance) {
+            nearest = i;
+            nearestDistance = distance;
+        }
+    }
+    return nearest;
+}
+
+QString DischargeSchedule::getHydroMapFilename(int index, const QString & hydroMapDirectory) {
+    if(index < 0) {
+        return QString();
+    }
+    return hydroMapDirectory + QDir::separator() + QString::number(index + 1) + "0k-new.txt";
+}
+
+const QVector<QString> & DischargeSchedule::getHydroMaps() const {
+    return hydroMaps;
+}
+
+const QVector<uint16_t> & DischargeSchedule::getDaysToRun() const {
+    return daysToRun;
+}
+
+int DischargeSchedule::getDays() const {
+    return days;
+}
+
+void DischargeSchedule::apply(Configuration & config) const {
+    config.hydroMapsSelected = hydroMaps;
+    config.daysToRun = daysToRun;
+    config.numHydroMaps = hydroMaps.size();
+}
@@ -0,0 +1,82 @@
+#ifndef DISCHARGESCHEDULE_H
+#define DISCHARGESCHEDULE_H
+
+#include <fstream>
+#include <limits>
+#include <QDir>
+#include <QString>
+#include <QVector>
+#include <stdint.h>
+#include <string>
+
+#include "configuration.h"
+
+/**
+ * @brief The DischargeSchedule class turns a file of daily river discharge, one value per
+ *        line, into the hydromaps to run and how many days to run each of them.
+ *
+ *        Hydromap i covers the discharges from minFlow[i] to maxFlow[i] and is named
+ *        (i+1)0k-new.txt, so the first one is 10k-new.txt.  Discharges outside every range
+ *        use the hydromap with the nearest range.  Consecutive days on the same hydromap
+ *        are run as one entry.  A file with a line that isn't a number gives an empty
+ *        schedule.
+ */
+class DischargeSchedule {
+    public:
+        /**
+         * @brief Default constructor, an empty schedule
+         */
+        DischargeSchedule();
+
+        /**
+         * @brief Builds the schedule for a discharge file
+         * @param dischargeFilename File with one daily discharge per line
+         * @param hydroMapDirectory Directory holding the hydromaps
+         * @param minFlow Lowest discharge of each hydromap
+         * @param maxFlow Highest discharge of each hydromap
+         */
+        DischargeSchedule(const QString & dischargeFilename, const QString & hydroMapDirectory,
+                          const QVector<int> & minFlow, const QVector<int> & maxFlow);
+
+        /**
+         * @brief Returns the hydromap covering a discharge
+         * @return The index into minFlow and maxFlow, or -1 if no range is valid
+         */
+        static int getHydroMapIndex(double discharge, const QVector<int> & minFlow,
+                                    const QVector<int> & maxFlow);
+
+        /**
+         * @brief Returns the file of a hydromap
+         * @param index Index into minFlow and maxFlow
+         * @param hydroMapDirectory Directory holding the hydromaps
+         * @return The hydromap's path, or an empty string if index is -1
+         */
+        static QString getHydroMapFilename(int index, const QString & hydroMapDirectory);
+
+        /**
+         * @brief Returns the hydromaps to run, in order
+         */
+        const QVector<QString> & getHydroMaps() const;
+
+        /**
+         * @brief Returns the days to run each hydromap
+         */
+        const QVector<uint16_t> & getDaysToRun() const;
+
+        /**
+         * @brief Returns the number of days of discharge read
+         */
+        int getDays() const;
+
+        /**
+         * @brief Replaces the configuration's hydromaps and days to run with the schedule
+         */
+        void apply(Configuration & config) const;
+
+    private:
+        QVector<QString> hydroMaps;
+        QVector<uint16_t> daysToRun;
+        int days;
+};
+
+#endif // DISCHARGESCHEDULE_H
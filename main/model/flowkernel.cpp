@@ -0,0 +1,134 @@
+#include "flowkernel.h"
+
+//The vectorized kernel is only built where we can ask the compiler for AVX2 on a single
+//function and check for it at runtime.  Everything else uses the scalar kernel.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FLOWKERNEL_HAS_AVX2
+#include <immintrin.h>
+#endif
+
+namespace {
+
+//Weights are read as double or float depending on whether the operator is compact,
+//the sums are always double so rounding does not build up over a patch's sources
+template <typename Weight>
+void transportScalarRows(const FlowOperator & flowOperator, const Weight * weights,
+                         const bool * hasWater, const double * source, double * dest)
+{
+    const int * rowOffsets = flowOperator.rowOffsets;
+    const int * columns = flowOperator.columns;
+
+    #pragma omp parallel for
+    for(int i = 0; i < flowOperator.getRows(); i++) {
+        if(!hasWater[i]) {
+            for(int stock = 0; stock < FLOW_STOCKS; stock++) {
+                dest[FLOW_STOCKS * i + stock] = source[FLOW_STOCKS * i + stock];
+            }
+            continue;
+        }
+
+        double DOC = 0.0;
+        double POC = 0.0;
+        double phyto = 0.0;
+        double waterdecomp = 0.0;
+
+        for(int entry = rowOffsets[i]; entry < rowOffsets[i + 1]; entry++) {
+            const double * sourcePatch = source + FLOW_STOCKS * columns[entry];
+            double sourceAmount = weights[entry];
+
+            DOC += sourcePatch[FLOW_DOC] * sourceAmount;
+            POC += sourcePatch[FLOW_POC] * sourceAmount;
+            phyto += sourcePatch[FLOW_PHYTO] * sourceAmount;
+            waterdecomp += sourcePatch[FLOW_WATERDECOMP] * sourceAmount;
+        }
+
+        double * destPatch = dest + FLOW_STOCKS * i;
+        destPatch[FLOW_DOC] = DOC;
+        destPatch[FLOW_POC] = POC;
+        destPatch[FLOW_PHYTO] = phyto;
+        destPatch[FLOW_WATERDECOMP] = waterdecomp;
+    }
+}
+
+#ifdef FLOWKERNEL_HAS_AVX2
+
+template <typename Weight>
+__attribute__((target("avx2,fma")))
+void transportAVX2Rows(const FlowOperator & flowOperator, const Weight * weights,
+                       const bool * hasWater, const double * source, double * dest)
+{
+    const int * rowOffsets = flowOperator.rowOffsets;
+    const int * columns = flowOperator.columns;
+
+    #pragma omp parallel for
+    for(int i = 0; i < flowOperator.getRows(); i++) {
+        if(!hasWater[i]) {
+            _mm256_storeu_pd(dest + FLOW_STOCKS * i, _mm256_loadu_pd(source + FLOW_STOCKS * i));
+            continue;
+        }
+
+        __m256d stocks = _mm256_setzero_pd();
+        for(int entry = rowOffsets[i]; entry < rowOffsets[i + 1]; entry++) {
+            __m256d sourcePatch = _mm256_loadu_pd(source + FLOW_STOCKS * columns[entry]);
+            __m256d sourceAmount = _mm256_set1_pd((double)weights[entry]);
+            stocks = _mm256_fmadd_pd(sourcePatch, sourceAmount, stocks);
+        }
+        _mm256_storeu_pd(dest + FLOW_STOCKS * i, stocks);
+    }
+}
+
+#endif
+
+}
+
+void FlowKernel::transportScalar(const FlowOperator & flowOperator, const bool * hasWater,
+                                 const double * source, double * dest)
+{
+    if(flowOperator.isCompact()) {
+        transportScalarRows(flowOperator, flowOperator.compactWeights, hasWater, source, dest);
+    } else {
+        transportScalarRows(flowOperator, flowOperator.weights, hasWater, source, dest);
+    }
+}
+
+#ifdef FLOWKERNEL_HAS_AVX2
+
+__attribute__((target("avx2,fma")))
+void FlowKernel::transportAVX2(const FlowOperator & flowOperator, const bool * hasWater,
+                               const double * source, double * dest)
+{
+    if(flowOperator.isCompact()) {
+        transportAVX2Rows(flowOperator, flowOperator.compactWeights, hasWater, source, dest);
+    } else {
+        transportAVX2Rows(flowOperator, flowOperator.weights, hasWater, source, dest);
+    }
+}
+
+#else
+
+void FlowKernel::transportAVX2(const FlowOperator & flowOperator, const bool * hasWater,
+                               const double * source, double * dest)
+{
+    transportScalar(flowOperator, hasWater, source, dest);
+}
+
+#endif
+
+FlowKernel::TransportFunction FlowKernel::selectTransport() {
+#ifdef FLOWKERNEL_HAS_AVX2
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return transportAVX2;
+    }
+#endif
+    return transportScalar;
+}
+
+const char * FlowKernel::getName(TransportFunction transport) {
+#ifdef FLOWKERNEL_HAS_AVX2
+    if(transport == transportAVX2) {
+        return "AVX2";
+    }
+#endif
+    return "scalar";
+}
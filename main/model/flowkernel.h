@@ -0,0 +1,49 @@
+#ifndef FLOWKERNEL_H
+#define FLOWKERNEL_H
+
+#include <omp.h>
+#include "constants.h"
+#include "flowoperator.h"
+
+/**
+ * @brief Kernels that transport the flowing stocks through a FlowOperator.
+ *
+ *        The stocks are stored interleaved, FLOW_STOCKS doubles per patch in the order
+ *        given by the FLOW_* enum, so every source entry is a single contiguous load and
+ *        one broadcast weight updates all of the stocks at once.
+ */
+namespace FlowKernel {
+
+    /**
+     * @brief Signature shared by all transport kernels.
+     * @param flowOperator Where each patch pulls its carbon from
+     * @param hasWater Patches without water do not flow, their stocks are copied as is
+     * @param source Interleaved stocks to pull from
+     * @param dest Interleaved stocks to write
+     */
+    typedef void (*TransportFunction)(const FlowOperator & flowOperator, const bool * hasWater,
+                                      const double * source, double * dest);
+
+    void transportScalar(const FlowOperator & flowOperator, const bool * hasWater,
+                         const double * source, double * dest);
+
+    /**
+     * @brief AVX2/FMA version of the kernel.  Only call this if the cpu supports it,
+     *        selectTransport() takes care of checking.
+     */
+    void transportAVX2(const FlowOperator & flowOperator, const bool * hasWater,
+                       const double * source, double * dest);
+
+    /**
+     * @brief Picks the fastest kernel the running cpu supports
+     */
+    TransportFunction selectTransport();
+
+    /**
+     * @brief Returns a printable name of the kernel, used for logging
+     */
+    const char * getName(TransportFunction transport);
+
+}
+
+#endif // FLOWKERNEL_H
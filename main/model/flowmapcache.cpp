@@ -0,0 +1,112 @@
+#include "flowmapcache.h"
+
+//Both CarbonFlowMap::writeFile and HydroFile::writeBinaryFile write a whole file
+namespace {
+    bool writeCached(const CarbonFlowMap & cached, const QString & filename) {
+        return cached.writeFile(filename);
+    }
+
+    bool writeCached(const HydroFile & cached, const QString & filename) {
+        return cached.writeBinaryFile(filename);
+    }
+}
+
+template <typename T>
+void FlowMapCache::addToCache(const T & cached, const QString & cacheFilename) const {
+    QTemporaryFile tempFile(cacheDirectory + "/XXXXXX.tmp");
+    tempFile.setAutoRemove(false);
+    if(!tempFile.open()) {
+        return;
+    }
+    QString tempFilename = tempFile.fileName();
+    tempFile.close();
+
+    if(!writeCached(cached, tempFilename)) {
+        QFile::remove(tempFilename);
+        return;
+    }
+
+    QFile::remove(cacheFilename);
+    if(!QFile::rename(tempFilename, cacheFilename)) {
+        QFile::remove(tempFilename);
+    }
+}
+
+FlowMapCache::FlowMapCache(const QString & newCacheDirectory, const QString & riverIOFilename) {
+    cacheDirectory = newCacheDirectory;
+    QDir().mkpath(cacheDirectory);
+
+    QFile riverIOFile(riverIOFilename);
+    if(riverIOFile.open(QIODevice::ReadOnly)) {
+        riverIOContents = riverIOFile.readAll();
+    }
+}
+
+QString FlowMapCache::getCacheFilename(const QString & hydroFilename, int iterations,
+                                       double trimMassFraction) const
+{
+    QFile hydroFile(hydroFilename);
+    if(!hydroFile.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    QString settings = QString("%1 %2 %3 %4 %5")
+            .arg(CARBON_FLOW_MAP_FILE_VERSION)
+            .arg(iterations)
+            .arg(PRECOMPUTED_FLOW_TRIM_THRESHOLD, 0, 'g', 17)
+            .arg(PATCH_LENGTH, 0, 'g', 17)
+            .arg(trimMassFraction, 0, 'g', 17);
+    hash.addData(settings.toLatin1());
+    hash.addData(hydroFile.readAll());
+    hash.addData(riverIOContents);
+
+    return cacheDirectory + "/" + QString(hash.result().toHex()) + ".cfm";
+}
+
+bool FlowMapCache::getCarbonFlowMap(const QString & hydroFilename, HydroFile * hydroFile,
+                                    int iterations, double trimMassFraction,
+                                    CarbonFlowMap & carbonFlowMap) const
+{
+    QString cacheFilename = getCacheFilename(hydroFilename, iterations, trimMassFraction);
+    if(!cacheFilename.isEmpty()
+            && carbonFlowMap.mapFile(cacheFilename, hydroFile, iterations, trimMassFraction))
+    {
+        return true;
+    }
+
+    carbonFlowMap = CarbonFlowMap(hydroFile, iterations, trimMassFraction);
+    if(!cacheFilename.isEmpty()) {
+        addToCache(carbonFlowMap, cacheFilename);
+    }
+    return false;
+}
+
+QString FlowMapCache::getHydroCacheFilename(const QString & hydroFilename) const {
+    QFile hydroFile(hydroFilename);
+    if(!hydroFile.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QString("hydromap %1").arg(HYDRO_FILE_VERSION).toLatin1());
+    hash.addData(hydroFile.readAll());
+    hash.addData(riverIOContents);
+
+    return cacheDirectory + "/" + QString(hash.result().toHex()) + ".hmb";
+}
+
+bool FlowMapCache::getHydroFile(const QString & hydroFilename, const RiverIOFile & riverIOFile,
+                                HydroFile & hydroFile) const
+{
+    QString cacheFilename = getHydroCacheFilename(hydroFilename);
+    if(!cacheFilename.isEmpty() && hydroFile.mapBinaryFile(cacheFilename)) {
+        return true;
+    }
+
+    hydroFile = HydroFile(hydroFilename, riverIOFile);
+    if(!cacheFilename.isEmpty()) {
+        addToCache(hydroFile, cacheFilename);
+    }
+    return false;
+}
@@ -0,0 +1,84 @@
+#ifndef FLOWMAPCACHE_H
+#define FLOWMAPCACHE_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QString>
+#include <QTemporaryFile>
+
+#include "carbonflowmap.h"
+#include "constants.h"
+#include "hydrofile.h"
+#include "riveriofile.h"
+
+/**
+ * @brief The FlowMapCache class keeps precomputed CarbonFlowMaps and binary conversions of
+ *        text hydromaps on disk between runs.
+ *
+ *        Each map is stored as <cacheDirectory>/<key>.cfm where the key is a SHA-1 of
+ *        everything the precompute depends on: the hydrofile and river IO file contents,
+ *        the number of iterations, the trimming settings, the patch size and the file
+ *        version.  Changing any of them produces a new key, so stale maps are never used.
+ *        Hydromaps are stored the same way as <key>.hmb, keyed on the hydrofile and river
+ *        IO file contents and the binary hydromap version.
+ */
+class FlowMapCache {
+    public:
+        /**
+         * @brief Creates the cache directory if needed and reads the river IO file
+         * @param newCacheDirectory Where cached maps are stored
+         * @param riverIOFilename The river IO file used for every hydrofile
+         */
+        FlowMapCache(const QString & newCacheDirectory, const QString & riverIOFilename);
+
+        /**
+         * @brief Fills in the flow map for a hydrofile, mapping it from the cache when it
+         *        is there and otherwise computing it and adding it to the cache.
+         * @param hydroFilename The file hydroFile was loaded from
+         * @param hydroFile The loaded hydroFile
+         * @param iterations The number of iterations to precompute
+         * @param trimMassFraction Adaptive trimming fraction, see CarbonFlowMap
+         * @param carbonFlowMap Receives the flow map
+         * @return True if the map came from the cache
+         */
+        bool getCarbonFlowMap(const QString & hydroFilename, HydroFile * hydroFile,
+                              int iterations, double trimMassFraction,
+                              CarbonFlowMap & carbonFlowMap) const;
+
+        /**
+         * @brief Returns the file a hydrofile's flow map is cached in
+         */
+        QString getCacheFilename(const QString & hydroFilename, int iterations,
+                                 double trimMassFraction) const;
+
+        /**
+         * @brief Loads a text hydromap, mapping its binary conversion from the cache when
+         *        it is there and otherwise parsing it and adding the conversion to the cache.
+         * @param hydroFilename The text hydromap to load
+         * @param riverIOFile The river IO file the cache was created with
+         * @param hydroFile Receives the hydromap
+         * @return True if the hydromap came from the cache
+         */
+        bool getHydroFile(const QString & hydroFilename, const RiverIOFile & riverIOFile,
+                          HydroFile & hydroFile) const;
+
+        /**
+         * @brief Returns the file a text hydromap's binary conversion is cached in
+         */
+        QString getHydroCacheFilename(const QString & hydroFilename) const;
+
+    private:
+        /**
+         * @brief Writes a CarbonFlowMap or HydroFile to the cache.  It is written to a
+         *        temporary file first so other runs never map a partially written file.
+         */
+        template <typename T>
+        void addToCache(const T & cached, const QString & cacheFilename) const;
+
+        QString cacheDirectory;
+        QByteArray riverIOContents;
+};
+
+#endif // FLOWMAPCACHE_H
@@ -0,0 +1,208 @@
+#include "flowoperator.h"
+
+FlowOperator::FlowOperator() {
+    allocate(0, 0);
+    rowOffsets[0] = 0;
+}
+
+FlowOperator::FlowOperator(HydroFile & hydroFile, const CarbonFlowMap & carbonFlowMap,
+                           const PatchCollection & patches)
+{
+    SourceArrays sourceData = carbonFlowMap.getSourceArrays();
+
+    //Patches that are land in this hydromap get an empty row
+    int totalSources = 0;
+    for(int i = 0; i < patches.getSize(); i++) {
+        int x = patches.pxcor[i];
+        int y = patches.pycor[i];
+        if(hydroFile.patchExists(x,y)) {
+            totalSources += sourceData.getSize(x,y);
+        }
+    }
+
+    allocate(patches.getSize(), totalSources);
+
+    int currOffset = 0;
+    for(int i = 0; i < rows; i++) {
+        rowOffsets[i] = currOffset;
+
+        int x = patches.pxcor[i];
+        int y = patches.pycor[i];
+        if(!hydroFile.patchExists(x,y)) {
+            continue;
+        }
+
+        int sourceOffset = sourceData.getOffset(x,y);
+        int numSources = sourceData.getSize(x,y);
+        for(int sourceIndex = 0; sourceIndex < numSources; sourceIndex++) {
+            int sourceX = sourceData.x[sourceOffset + sourceIndex];
+            int sourceY = sourceData.y[sourceOffset + sourceIndex];
+
+            columns[currOffset] = patches.getIndex(sourceX, sourceY);
+            weights[currOffset] = sourceData.amount[sourceOffset + sourceIndex];
+            currOffset++;
+        }
+    }
+    rowOffsets[rows] = currOffset;
+}
+
+FlowOperator::FlowOperator(const FlowOperator & other) {
+    copy(other);
+}
+
+FlowOperator::~FlowOperator() {
+    clear();
+}
+
+FlowOperator & FlowOperator::operator=(const FlowOperator & rhs) {
+    if(this != &rhs) {
+        clear();
+        copy(rhs);
+    }
+    return *this;
+}
+
+int FlowOperator::getRows() const {
+    return rows;
+}
+
+int FlowOperator::getNonZeros() const {
+    return nonZeros;
+}
+
+size_t FlowOperator::getBytes() const {
+    size_t weightBytes = isCompact() ? sizeof(float) : sizeof(double);
+    return sizeof(int) * (rows + 1) + (sizeof(int) + weightBytes) * (size_t)nonZeros;
+}
+
+void FlowOperator::compact() {
+    if(isCompact()) {
+        return;
+    }
+
+    compactWeights = new float[nonZeros];
+    for(int i = 0; i < nonZeros; i++) {
+        compactWeights[i] = (float)weights[i];
+    }
+    delete [] weights;
+    weights = NULL;
+}
+
+bool FlowOperator::isCompact() const {
+    return compactWeights != NULL;
+}
+
+FlowOperator FlowOperator::multiply(const FlowOperator & other, double trimThreshold) const {
+    QVector< QVector<int> > productColumns(rows);
+    QVector< QVector<double> > productWeights(rows);
+
+    #pragma omp parallel
+    {
+        //Dense scratch row, lastRow marks which columns have been touched by the current row
+        QVector<double> sums(other.rows);
+        QVector<int> lastRow(other.rows, -1);
+        QVector<int> touched;
+
+        #pragma omp for schedule(dynamic, 64)
+        for(int i = 0; i < rows; i++) {
+            touched.clear();
+
+            //Patch i pulls from patch k, which in turn pulled from patch j
+            for(int entry = rowOffsets[i]; entry < rowOffsets[i + 1]; entry++) {
+                int k = columns[entry];
+                double amount = weights[entry];
+
+                for(int otherEntry = other.rowOffsets[k]; otherEntry < other.rowOffsets[k + 1]; otherEntry++) {
+                    int j = other.columns[otherEntry];
+                    if(lastRow[j] != i) {
+                        lastRow[j] = i;
+                        sums[j] = 0.0;
+                        touched.append(j);
+                    }
+                    sums[j] += amount * other.weights[otherEntry];
+                }
+            }
+
+            std::sort(touched.begin(), touched.end());
+            for(int t = 0; t < touched.size(); t++) {
+                int j = touched[t];
+                if(sums[j] > trimThreshold) {
+                    productColumns[i].append(j);
+                    productWeights[i].append(sums[j]);
+                }
+            }
+        }
+    }
+
+    int totalEntries = 0;
+    for(int i = 0; i < rows; i++) {
+        totalEntries += productColumns[i].size();
+    }
+
+    FlowOperator product;
+    product.clear();
+    product.allocate(rows, totalEntries);
+
+    int currOffset = 0;
+    for(int i = 0; i < rows; i++) {
+        product.rowOffsets[i] = currOffset;
+        for(int t = 0; t < productColumns[i].size(); t++) {
+            product.columns[currOffset] = productColumns[i][t];
+            product.weights[currOffset] = productWeights[i][t];
+            currOffset++;
+        }
+    }
+    product.rowOffsets[rows] = currOffset;
+
+    return product;
+}
+
+void FlowOperator::apply(const double * source, double * dest) const {
+    #pragma omp parallel for
+    for(int i = 0; i < rows; i++) {
+        double sum = 0.0;
+        for(int entry = rowOffsets[i]; entry < rowOffsets[i + 1]; entry++) {
+            sum += source[columns[entry]] * weights[entry];
+        }
+        dest[i] = sum;
+    }
+}
+
+void FlowOperator::allocate(int newRows, int newNonZeros) {
+    rows = newRows;
+    nonZeros = newNonZeros;
+    rowOffsets = new int[rows + 1];
+    columns = new int[nonZeros];
+    weights = new double[nonZeros];
+    compactWeights = NULL;
+}
+
+void FlowOperator::copy(const FlowOperator & other) {
+    allocate(other.rows, other.nonZeros);
+    for(int i = 0; i <= rows; i++) {
+        rowOffsets[i] = other.rowOffsets[i];
+    }
+    for(int i = 0; i < nonZeros; i++) {
+        columns[i] = other.columns[i];
+    }
+
+    if(other.isCompact()) {
+        delete [] weights;
+        weights = NULL;
+        compactWeights = new float[nonZeros];
+        for(int i = 0; i < nonZeros; i++) {
+            compactWeights[i] = other.compactWeights[i];
+        }
+    } else {
+        for(int i = 0; i < nonZeros; i++) {
+            weights[i] = other.weights[i];
+        }
+    }
+}
+
+void FlowOperator::clear() {
+    delete [] rowOffsets;
+    delete [] columns;
+    delete [] weights;
+    delete [] compactWeights;
+}
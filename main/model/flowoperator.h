@@ -0,0 +1,101 @@
+#ifndef FLOWOPERATOR_H
+#define FLOWOPERATOR_H
+
+#include <algorithm>
+#include <QVector>
+
+#include "carbonflowmap.h"
+#include "hydrofile.h"
+#include "patchcollection.h"
+
+/**
+ * @brief The FlowOperator class stores a CarbonFlowMap as a sparse matrix in compressed
+ *        sparse row (CSR) form over PatchCollection indices.
+ *
+ *        Row i lists where patch i pulls its carbon from: the entries between
+ *        rowOffsets[i] and rowOffsets[i+1] hold the index of a source patch and the
+ *        fraction of that patch's carbon that is received.  Because both the rows and the
+ *        columns are patch indices, the flow loop reads and writes dense patch-indexed
+ *        arrays directly instead of chasing (x,y) lookups through full width*height grids
+ *        that are mostly land.
+ */
+class FlowOperator {
+    public:
+        /**
+         * @brief Default constructor, creates an empty operator
+         */
+        FlowOperator();
+
+        /**
+         * @brief Builds the operator from a hydromap's precomputed CarbonFlowMap
+         * @param hydroFile The hydromap the flows were computed for
+         * @param carbonFlowMap The precomputed flows to convert
+         * @param patches The patches of the river. Rows and columns use their indices.
+         */
+        FlowOperator(HydroFile & hydroFile, const CarbonFlowMap & carbonFlowMap,
+                     const PatchCollection & patches);
+
+        //Big 3
+        FlowOperator(const FlowOperator & other);
+        ~FlowOperator();
+        FlowOperator & operator=(const FlowOperator & rhs);
+
+        /**
+         * @brief Returns the number of rows (patches) in the operator
+         */
+        int getRows() const;
+
+        /**
+         * @brief Returns the total number of sources stored in the operator
+         */
+        int getNonZeros() const;
+
+        /**
+         * @brief Returns the number of bytes read from the operator by one flow
+         */
+        size_t getBytes() const;
+
+        /**
+         * @brief Replaces the double weights with floats, which cuts the bytes read by
+         *        every flow by a third.  Kernels still accumulate in double precision.
+         *        multiply() and apply() need the double weights so compose first.
+         */
+        void compact();
+
+        /**
+         * @brief Returns true once compact() has been called
+         */
+        bool isCompact() const;
+
+        /**
+         * @brief Composes two operators into one.  Applying the result is the same as
+         *        applying other and then this operator, except that entries at or below
+         *        the trim threshold are dropped just like in CarbonFlowMap.
+         * @param other The operator applied first
+         * @param trimThreshold Smallest fraction that is kept in the result
+         * @return The composed operator
+         */
+        FlowOperator multiply(const FlowOperator & other, double trimThreshold) const;
+
+        /**
+         * @brief Applies the operator to a single patch indexed value
+         * @param source Values to pull from, one per patch
+         * @param dest Receives the result, one per patch
+         */
+        void apply(const double * source, double * dest) const;
+
+        int * rowOffsets;   ///< rows + 1 offsets into columns/weights
+        int * columns;      ///< source patch index of each entry
+        double * weights;   ///< fraction of the source patch's carbon received, NULL once compact
+        float * compactWeights;  ///< the same fractions as floats, NULL until compact
+
+    private:
+        int rows;
+        int nonZeros;
+
+        void allocate(int newRows, int newNonZeros);
+        void copy(const FlowOperator & other);
+        void clear();
+};
+
+#endif // FLOWOPERATOR_H
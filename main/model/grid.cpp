@@ -31,6 +31,20 @@ Grid<T> & Grid<T>::operator=(const Grid<T> & rhs) {
     return *this;
 }
 
+template <typename T>
+Grid<T>::Grid(Grid<T> && other) {
+    move(other);
+}
+
+template <typename T>
+Grid<T> & Grid<T>::operator=(Grid<T> && rhs) {
+    if(this != &rhs) {
+        clear();
+        move(rhs);
+    }
+    return *this;
+}
+
 template <typename T>
 Grid<T>::~Grid() {
     clear();
@@ -60,7 +74,7 @@ const T & Grid<T>::operator()(std::size_t index) const {
 
 template <typename T>
 T * Grid<T>::getArray(void) {
-    return array[0];
+    return array;
 }
 
 template <typename T>
@@ -113,3 +127,16 @@ void Grid<T>::copy(const Grid<T> & other) {
         array[i] = other.array[i];
     }
 }
+
+template <typename T>
+void Grid<T>::move(Grid<T> & other) {
+    width = other.width;
+    height = other.height;
+    size = other.size;
+    array = other.array;
+
+    other.width = 0;
+    other.height = 0;
+    other.size = 0;
+    other.array = NULL;
+}
@@ -25,6 +25,19 @@ class Grid {
          */
         Grid<T> & operator=(const Grid<T> & rhs);
 
+        /**
+         * @brief Grid move constructor, takes the other grid's array and leaves it empty
+         * @param other A grid to move
+         */
+        Grid(Grid<T> && other);
+
+        /**
+         * @brief Move assignment operator
+         * @param rhs Grid to move
+         * @return this Grid object
+         */
+        Grid<T> & operator=(Grid<T> && rhs);
+
         /**
          * @brief Destructor
          */
@@ -120,6 +133,12 @@ class Grid {
          */
         void copy(const Grid<T> & other);
 
+        /**
+         * @brief Grid move helper
+         * @param other A grid to move
+         */
+        void move(Grid<T> & other);
+
         /**
          * @brief Helper that clears the grid object
          */
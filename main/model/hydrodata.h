@@ -3,10 +3,16 @@
 
 #include "hydrofile.h"
 #include "carbonflowmap.h"
+#include "patchhydrodata.h"
 
 struct HydroData {
     HydroFile hydroFile;
     CarbonFlowMap carbonFlowMap;
+    //Covers the minutes left in an hour when the precompute depth does not divide it.
+    //Left uninitialized otherwise.
+    CarbonFlowMap remainderFlowMap;
+    //The hydromap over the patches of HydroFileDict::getGeometry()
+    PatchHydroData patchHydroData;
 };
 
 #endif // HYDRODATA_H
@@ -1,93 +1,260 @@
 #include "hydrofile.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <omp.h>
 using std::cout;
 using std::endl;
 
+namespace {
 
-HydroFile::HydroFile(QString filename, RiverIOFile riverIOFile){
-    hydroFileLoaded = false;
+bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/* Finds the next whitespace separated token.  On success token points to its first
+ * character and position is left one past its last.
+ */
+bool nextToken(const char * & position, const char * end, const char * & token) {
+    while(position < end && isSpace(*position)) {
+        position++;
+    }
+    if(position == end) {
+        return false;
+    }
+
+    token = position;
+    while(position < end && !isSpace(*position)) {
+        position++;
+    }
+    return true;
+}
+
+int parseInt(const char * begin, const char * end) {
+    const char * c = begin;
+    bool negative = false;
+    if(c < end && (*c == '-' || *c == '+')) {
+        negative = (*c == '-');
+        c++;
+    }
+
+    int value = 0;
+    const char * digits = c;
+    while(c < end && isDigit(*c) && c - digits < 9) {
+        value = value * 10 + (*c - '0');
+        c++;
+    }
+
+    //Anything unusual is left to Qt so we match what QString::toInt() used to give
+    if(c != end || c == digits) {
+        return QByteArray(begin, end - begin).toInt();
+    }
+    return negative ? -value : value;
+}
+
+/* Reads a plain decimal like -0.0170.  When the digits fit in the 53 bit mantissa of a
+ * double, dividing by an exact power of ten is correctly rounded, so the result is the
+ * same double QString::toDouble() gives.  Anything else is left to Qt.
+ */
+double parseDouble(const char * begin, const char * end) {
+    static const double powersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const unsigned long long maxMantissa = 1ULL << 53;
+
+    const char * c = begin;
+    bool negative = false;
+    if(c < end && (*c == '-' || *c == '+')) {
+        negative = (*c == '-');
+        c++;
+    }
+
+    unsigned long long mantissa = 0;
+    int digitCount = 0;
+    int fractionDigits = 0;
+    bool exact = true;
+    while(c < end && isDigit(*c)) {
+        mantissa = mantissa * 10 + (*c - '0');
+        exact = exact && mantissa <= maxMantissa;
+        digitCount++;
+        c++;
+    }
+    if(c < end && *c == '.') {
+        c++;
+        while(c < end && isDigit(*c)) {
+            mantissa = mantissa * 10 + (*c - '0');
+            exact = exact && mantissa <= maxMantissa;
+            digitCount++;
+            fractionDigits++;
+            c++;
+        }
+    }
+
+    if(c != end || digitCount == 0 || !exact || fractionDigits > 22) {
+        return QByteArray(begin, end - begin).toDouble();
+    }
+
+    double value = (double)mantissa / powersOfTen[fractionDigits];
+    return negative ? -value : value;
+}
+
+/* Layout of a binary hydromap.  The header is followed by the name of the text hydromap
+ * it was converted from and then one array per field, padded to multiples of 8 bytes.
+ */
+struct HydroFileHeader {
+    char magic[4];
+    qint32 version;
+    qint32 byteOrder;
+    qint32 width;
+    qint32 height;
+    qint32 cells;
+    qint32 waterCellCount;
+    qint32 nameBytes;
+    double maxDepth;
+    double maxFlow;
+};
+
+const char HYDRO_FILE_MAGIC[4] = {'H', 'Y', 'D', 'M'};
+const qint32 HYDRO_FILE_BYTE_ORDER = 0x01020304;
+
+qint64 padded(qint64 bytes) {
+    return (bytes + 7) / 8 * 8;
+}
+
+//Byte offsets of the arrays of a binary hydromap
+struct HydroFileLayout {
+    qint64 cellX;
+    qint64 cellY;
+    qint64 depths;
+    qint64 flowVectors;
+    qint64 fileVelocities;
+    qint64 ioFlags;
+    qint64 cellIndices;
+    qint64 size;
+
+    HydroFileLayout(qint64 cells, qint64 nameBytes, qint64 mapCells) {
+        cellX = sizeof(HydroFileHeader) + padded(nameBytes);
+        cellY = cellX + sizeof(qint32) * cells;
+        depths = padded(cellY + sizeof(qint32) * cells);
+        flowVectors = depths + sizeof(double) * cells;
+        fileVelocities = flowVectors + 2 * sizeof(float) * cells;
+        ioFlags = fileVelocities + sizeof(double) * cells;
+        cellIndices = padded(ioFlags + cells);
+        size = cellIndices + sizeof(qint32) * mapCells;
+    }
+};
+
+}
+
+
+HydroFile::HydroFile(QString filename, const RiverIOFile & riverIOFile){
+    clear();
     loadFromFile(filename, riverIOFile);
 }
 
 HydroFile::HydroFile() {
-    hydroFileLoaded = false;
+    clear();
+}
+
+HydroFile::HydroFile(const HydroFile & other) {
+    copy(other);
+}
+
+HydroFile & HydroFile::operator=(const HydroFile & rhs) {
+    if(this != &rhs) {
+        clear();
+        copy(rhs);
+    }
+    return *this;
+}
+
+HydroFile::HydroFile(HydroFile && other) {
+    move(other);
+}
+
+HydroFile & HydroFile::operator=(HydroFile && rhs) {
+    if(this != &rhs) {
+        clear();
+        move(rhs);
+    }
+    return *this;
+}
+
+HydroFile::~HydroFile() {
+    clear();
 }
 
 
-void HydroFile::loadFromFile(QString filename, RiverIOFile riverIOFile) {
+void HydroFile::loadFromFile(QString filename, const RiverIOFile & riverIOFile) {
 
     /* Once loaded, a hydrofile represents only one hydromap. */
     if( hydroFileLoaded )
         return;
 
-    setHydroIndex(filename);
-
-    hydroMapFileName = filename;
+    if(mapBinaryFile(filename)) {
+        return;
+    }
 
     QFile hydroFile( filename );
-    if( !hydroFile.open(QIODevice::ReadOnly | QIODevice::Text) ) {
+    if( !hydroFile.open(QIODevice::ReadOnly) ) {
         printf("Failed to open the hydromap");
         exit(1);
     }
 
-    waterCellCount = 0;
-    maxDepth = 0.0;
-    maxFlow = 0.0;
+    int newWaterCellCount = 0;
+    double newMaxDepth = 0.0;
+    double newMaxFlow = 0.0;
 
-    QString hydroFileText = hydroFile.readAll();
-    QStringList hydroFileData = hydroFileText.split(" ");
+    /* Parse the cells straight out of the mapped file so we never hold the text
+     * of the whole map as strings.  If the file cannot be mapped it is read instead.
+     */
+    QVector<HydroData> records;
+    qint64 fileSize = hydroFile.size();
+    uchar * mappedText = NULL;
+    if(fileSize > 0) {
+        mappedText = hydroFile.map(0, fileSize);
+    }
+    if(mappedText != NULL) {
+        const char * fileData = reinterpret_cast<const char *>(mappedText);
+        parseRecords(fileData, fileData + fileSize, records);
+        hydroFile.unmap(mappedText);
+    } else {
+        QByteArray fileData = hydroFile.readAll();
+        parseRecords(fileData.constData(), fileData.constData() + fileData.size(), records);
+    }
+    hydroFile.close();
 
     //Determine dimensions of map and setup a blank grid
-    setMapSize(hydroFileData);
+    setMapSize(records);
     Grid<HydroData> hydroData(width, height);
     zeroHydroData(hydroData);
 
 
     /* The data in the file is not in order so we first organize it in a grid
-     * before moving it to a vector.  While we are at it we record some
-     * information about the map.  Note that every six elements are related
-     * to a cell.  The first six are skipped since are they names for the columns.
+     * before moving it to the arrays.  While we are at it we record some
+     * information about the map.
      */
-    for(int index = 6; index < hydroFileData.size(); index += 6) {
-        HydroData data;
-
-        int patch_x = hydroFileData[index].toInt();
-        int patch_y = hydroFileData[index + 1].toInt();
+    for(int i = 0; i < records.size(); i++) {
+        const HydroData & data = records[i];
 
-        data.depth          = hydroFileData[index + 2].toDouble();
-        data.flowVector.setX( hydroFileData[index + 3].toDouble() );
-        data.flowVector.setY( hydroFileData[index + 4].toDouble() );
-        data.fileVelocity   = hydroFileData[index + 5].toDouble();
-        data.isInput = false;
-        data.isOutput = false;
-
-        hydroData(patch_x, patch_y) = data;
+        hydroData(data.x, data.y) = data;
 
         if(data.depth > 0){
-            waterCellCount++;
-            if(data.depth > maxDepth) {
-                maxDepth = data.depth;
+            newWaterCellCount++;
+            if(data.depth > newMaxDepth) {
+                newMaxDepth = data.depth;
             }
-            if(data.flowVector.length() > maxFlow) {
-                maxFlow = data.flowVector.length();
-            }
-        }
-    }
-
-
-    /* Now we move the data from the grid and place it in a vector whose
-     * element indices are hashed using the x,y coordinates of corresponding
-     * cells   
-     */
-    for(unsigned int x = 0; x < hydroData.getWidth(); x++) {
-        for(unsigned int y = 0; y < hydroData.getHeight(); y++) {
-            if(hydroData(x,y).depth != 0) {
-                hydroDataSet.append(hydroData(x,y));
-                int index = getHashKey(x,y);
-                hydroDataSetIndices.insert(index,hydroDataSet.size()-1); 
+            if(data.flowVector.length() > newMaxFlow) {
+                newMaxFlow = data.flowVector.length();
             }
         }
     }
+    records.clear();
 
     /*
      * We need to check if a patch exists because the riverIO file is for all hydroFiles
@@ -95,43 +262,199 @@ void HydroFile::loadFromFile(QString filename, RiverIOFile riverIOFile) {
      */
     for(int i = 0; i < riverIOFile.inputs.size(); i++){
         QPoint point = riverIOFile.inputs[i];
-        if(patchExists(point.x(), point.y()) ) {
-            int hashKey = getHashKey(point.x(), point.y());
-            int index = hydroDataSetIndices[hashKey];
-            hydroDataSet[index].isInput = true;
+        if(point.x() >= 0 && point.x() < width && point.y() >= 0 && point.y() < height
+                && hydroData(point.x(), point.y()).depth != 0) {
+            hydroData(point.x(), point.y()).isInput = true;
         }
     }
 
     for(int i = 0; i < riverIOFile.outputs.size(); i++){
         QPoint point = riverIOFile.outputs[i];
-        if(patchExists(point.x(), point.y()) ) {
-            int hashKey = getHashKey(point.x(), point.y());
-            int index = hydroDataSetIndices[hashKey];
-            hydroDataSet[index].isOutput = true;
+        if(point.x() >= 0 && point.x() < width && point.y() >= 0 && point.y() < height
+                && hydroData(point.x(), point.y()).depth != 0) {
+            hydroData(point.x(), point.y()).isOutput = true;
         }
     }
 
-    hydroFile.close();
+    /* Now we move the data from the grid into the arrays of a binary hydromap
+     * whose cells are indexed using their x,y coordinates
+     */
+    int newCells = 0;
+    for(unsigned int x = 0; x < hydroData.getWidth(); x++) {
+        for(unsigned int y = 0; y < hydroData.getHeight(); y++) {
+            if(hydroData(x,y).depth != 0) {
+                newCells++;
+            }
+        }
+    }
+
+    QByteArray name = filename.toUtf8();
+    HydroFileLayout layout(newCells, name.size(), (qint64)width * height);
+
+    HydroFileHeader header;
+    memcpy(header.magic, HYDRO_FILE_MAGIC, sizeof(header.magic));
+    header.version = HYDRO_FILE_VERSION;
+    header.byteOrder = HYDRO_FILE_BYTE_ORDER;
+    header.width = width;
+    header.height = height;
+    header.cells = newCells;
+    header.waterCellCount = newWaterCellCount;
+    header.nameBytes = name.size();
+    header.maxDepth = newMaxDepth;
+    header.maxFlow = newMaxFlow;
+
+    cellData = QByteArray((int)layout.size, '\0');
+    char * data = cellData.data();
+    memcpy(data, &header, sizeof(header));
+    memcpy(data + sizeof(header), name.constData(), name.size());
+
+    int * newCellX = (int *)(data + layout.cellX);
+    int * newCellY = (int *)(data + layout.cellY);
+    double * newDepths = (double *)(data + layout.depths);
+    float * newFlowVectors = (float *)(data + layout.flowVectors);
+    double * newFileVelocities = (double *)(data + layout.fileVelocities);
+    unsigned char * newIOFlags = (unsigned char *)(data + layout.ioFlags);
+    int * newCellIndices = (int *)(data + layout.cellIndices);
+    for(int i = 0; i < width * height; i++) {
+        newCellIndices[i] = -1;
+    }
+
+    int cell = 0;
+    for(unsigned int x = 0; x < hydroData.getWidth(); x++) {
+        for(unsigned int y = 0; y < hydroData.getHeight(); y++) {
+            const HydroData & cellHydroData = hydroData(x,y);
+            if(cellHydroData.depth != 0) {
+                newCellX[cell] = x;
+                newCellY[cell] = y;
+                newDepths[cell] = cellHydroData.depth;
+                newFlowVectors[2 * cell] = cellHydroData.flowVector.x();
+                newFlowVectors[2 * cell + 1] = cellHydroData.flowVector.y();
+                newFileVelocities[cell] = cellHydroData.fileVelocity;
+                newIOFlags[cell] = (cellHydroData.isInput ? HYDRO_FILE_INPUT : 0)
+                        | (cellHydroData.isOutput ? HYDRO_FILE_OUTPUT : 0);
+                newCellIndices[getHashKey(x,y)] = cell;
+                cell++;
+            }
+        }
+    }
+
+    setArrays(cellData.constData());
     hydroFileLoaded = true;
 }
 
-bool HydroFile::patchExists(int x, int y) const {
-    if(x >= width || x < 0 || y >= height || y < 0)
+bool HydroFile::writeBinaryFile(const QString & filename) const {
+    if(!hydroFileLoaded) {
+        return false;
+    }
+
+    HydroFileHeader header;
+    memcpy(&header, image, sizeof(header));
+    qint64 size = HydroFileLayout(header.cells, header.nameBytes,
+                                  (qint64)header.width * header.height).size;
+
+    QFile file(filename);
+    if(!file.open(QIODevice::WriteOnly)) {
         return false;
-    int hashKey = getHashKey(x,y);
-    return hydroDataSetIndices.contains(hashKey);
+    }
+
+    bool written = file.write(image, size) == size;
+    file.close();
+
+    return written && file.error() == QFile::NoError;
+}
+
+bool HydroFile::mapBinaryFile(const QString & filename) {
+    QSharedPointer<QFile> file(new QFile(filename));
+    if(!file->open(QIODevice::ReadOnly) || file->size() < (qint64)sizeof(HydroFileHeader)) {
+        return false;
+    }
+
+    //Check the header before mapping, most files we are asked about are text hydromaps
+    HydroFileHeader header;
+    if(file->read((char *)&header, sizeof(header)) != (qint64)sizeof(header)) {
+        return false;
+    }
+
+    bool valid = memcmp(header.magic, HYDRO_FILE_MAGIC, sizeof(header.magic)) == 0
+            && header.version == HYDRO_FILE_VERSION
+            && header.byteOrder == HYDRO_FILE_BYTE_ORDER
+            && header.width > 0
+            && header.height > 0
+            && header.cells >= 0
+            && header.nameBytes >= 0
+            && file->size() == HydroFileLayout(header.cells, header.nameBytes,
+                                               (qint64)header.width * header.height).size;
+    if(!valid) {
+        return false;
+    }
+
+    uchar * data = file->map(0, file->size());
+    if(data == NULL) {
+        return false;
+    }
+
+    clear();
+
+    //The mapping is read only, a hydromap is never changed once loaded
+    mappedFile = file;
+    setArrays((const char *)data);
+    hydroFileLoaded = true;
+    return true;
+}
+
+int HydroFile::getCellCount() const {
+    return cells;
+}
+
+int HydroFile::getCellIndex(int x, int y) const {
+    if(x >= width || x < 0 || y >= height || y < 0)
+        return -1;
+    return cellIndices[getHashKey(x,y)];
 }
 
-const QVector2D & HydroFile::getVector(int x, int y) {
-    return getData(x,y).flowVector;
+const int * HydroFile::getCellIndices() const {
+    return cellIndices;
+}
+
+const int * HydroFile::getCellX() const {
+    return cellX;
+}
+
+const int * HydroFile::getCellY() const {
+    return cellY;
+}
+
+const double * HydroFile::getDepths() const {
+    return depths;
+}
+
+const float * HydroFile::getFlowVectors() const {
+    return flowVectors;
+}
+
+const double * HydroFile::getFileVelocities() const {
+    return fileVelocities;
+}
+
+const unsigned char * HydroFile::getIOFlags() const {
+    return ioFlags;
+}
+
+bool HydroFile::patchExists(int x, int y) const {
+    return getCellIndex(x,y) >= 0;
+}
+
+QVector2D HydroFile::getVector(int x, int y) {
+    int index = getIndex(x,y);
+    return QVector2D(flowVectors[2 * index], flowVectors[2 * index + 1]);
 }
 
 double HydroFile::getDepth(int x, int y) {
-    return getData(x,y).depth;
+    return depths[getIndex(x,y)];
 }
 
 double HydroFile::getFileVelocity(int x, int y) {
-    return getData(x,y).fileVelocity;
+    return fileVelocities[getIndex(x,y)];
 }
 
 int HydroFile::getMapHeight() const {
@@ -146,28 +469,128 @@ int HydroFile::getHydroIndex() const {
     return hydroIndex;
 }
 
+QString HydroFile::getFileName() const {
+    return hydroMapFileName;
+}
+
 bool HydroFile::isInput(int x, int y) {
-    return getData(x,y).isInput;
+    return (ioFlags[getIndex(x,y)] & HYDRO_FILE_INPUT) != 0;
 }
 
 bool HydroFile::isOutput(int x, int y) {
-    return getData(x,y).isOutput;
+    return (ioFlags[getIndex(x,y)] & HYDRO_FILE_OUTPUT) != 0;
 }
 
-void HydroFile::setMapSize(QStringList & hydroFileData) {
-    int maxX = 0;
-    int maxY = 0;
+void HydroFile::parseRecords(const char * begin, const char * end,
+                             QVector<HydroData> & records) const
+{
+    int chunks = std::min<qint64>((end - begin) / HYDRO_FILE_PARSE_CHUNK_BYTES, omp_get_max_threads());
+    chunks = std::max(chunks, 1);
+
+    //Chunks end on whitespace so that no value is split between two of them
+    QVector<const char *> bounds(chunks + 1);
+    bounds[0] = begin;
+    for(int c = 1; c < chunks; c++) {
+        const char * bound = std::max(begin + (end - begin) / chunks * c, bounds[c - 1]);
+        while(bound < end && !isSpace(*bound)) {
+            bound++;
+        }
+        bounds[c] = bound;
+    }
+    bounds[chunks] = end;
+
+    //firstTokens[c] becomes the number of values before chunk c
+    QVector<qint64> firstTokens(chunks + 1, 0);
+    if(chunks > 1) {
+        #pragma omp parallel for
+        for(int c = 0; c < chunks; c++) {
+            const char * position = bounds[c];
+            const char * token;
+            qint64 count = 0;
+            while(nextToken(position, bounds[c + 1], token)) {
+                count++;
+            }
+            firstTokens[c + 1] = count;
+        }
+        for(int c = 0; c < chunks; c++) {
+            firstTokens[c + 1] += firstTokens[c];
+        }
+    }
+
+    QVector<QVector<HydroData> > chunkRecords(chunks);
+    #pragma omp parallel for if(chunks > 1)
+    for(int c = 0; c < chunks; c++) {
+        parseChunk(bounds[c], bounds[c + 1], end, firstTokens[c], chunkRecords[c]);
+    }
+
+    if(chunks == 1) {
+        records = chunkRecords[0];
+        return;
+    }
+
+    int totalRecords = 0;
+    for(int c = 0; c < chunks; c++) {
+        totalRecords += chunkRecords[c].size();
+    }
+    records.reserve(totalRecords);
+    for(int c = 0; c < chunks; c++) {
+        records += chunkRecords[c];
+    }
+}
+
+void HydroFile::parseChunk(const char * chunkBegin, const char * chunkEnd, const char * end,
+                           qint64 firstToken, QVector<HydroData> & records) const
+{
+    const char * position = chunkBegin;
+    const char * token;
+
+    //Every six values are related to a cell.  The first six are the names of the columns.
+    //Skip them and the rest of a cell that started in an earlier chunk.
+    for(qint64 tokenIndex = firstToken; tokenIndex < 6 || tokenIndex % 6 != 0; tokenIndex++) {
+        if(!nextToken(position, chunkEnd, token)) {
+            return;
+        }
+    }
+
+    const char * tokens[12];
+    while(true) {
+        //Each value is a token begin/end pair
+        for(int column = 0; column < 6; column++) {
+            if(!nextToken(position, end, token)) {
+                return;
+            }
+            //Cells starting past the chunk belong to the next one
+            if(column == 0 && token >= chunkEnd) {
+                return;
+            }
+            tokens[2 * column] = token;
+            tokens[2 * column + 1] = position;
+        }
+
+        HydroData data;
+        data.x              = parseInt(tokens[0], tokens[1]);
+        data.y              = parseInt(tokens[2], tokens[3]);
+        data.depth          = parseDouble(tokens[4], tokens[5]);
+        data.flowVector.setX( parseDouble(tokens[6], tokens[7]) );
+        data.flowVector.setY( parseDouble(tokens[8], tokens[9]) );
+        data.fileVelocity   = parseDouble(tokens[10], tokens[11]);
+        data.isInput = false;
+        data.isOutput = false;
 
-    for(int index = 6; index < hydroFileData.size(); index += 6) {
+        records.append(data);
+    }
+}
 
-        int patch_x = hydroFileData[index].toInt();
-        int patch_y = hydroFileData[index + 1].toInt();
+void HydroFile::setMapSize(const QVector<HydroData> & records) {
+    int maxX = 0;
+    int maxY = 0;
 
-        if(patch_x > maxX) {
-            maxX = patch_x;
+    for(int i = 0; i < records.size(); i++) {
+        if(records[i].x > maxX) {
+            maxX = records[i].x;
         }
-        if(patch_y > maxY) {
-            maxY = patch_y;
+        if(records[i].y > maxY) {
+            maxY = records[i].y;
         }
     }
 
@@ -179,16 +602,89 @@ int HydroFile::getHashKey(int x, int y) const {
     return (y * width + x);
 }
 
-HydroFile::HydroData & HydroFile::getData(int x, int y) {
+int HydroFile::getIndex(int x, int y) const {
     if(!patchExists(x,y))
     {
-        std::cerr << "Cannot return a location that doesn't exist, use patchExists() before calling getData()!";
+        std::cerr << "Cannot return a location that doesn't exist, use patchExists() before calling getIndex()!";
         std::cerr << std::endl;
         abort();
     }
-    int hashKey = getHashKey(x,y);
-    int index = hydroDataSetIndices[hashKey];
-    return hydroDataSet[index];
+    return cellIndices[getHashKey(x,y)];
+}
+
+void HydroFile::setArrays(const char * data) {
+    HydroFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    HydroFileLayout layout(header.cells, header.nameBytes, (qint64)header.width * header.height);
+
+    hydroMapFileName = QString::fromUtf8(data + sizeof(header), header.nameBytes);
+    setHydroIndex(hydroMapFileName);
+    width = header.width;
+    height = header.height;
+    waterCellCount = header.waterCellCount;
+    maxDepth = header.maxDepth;
+    maxFlow = header.maxFlow;
+
+    cells = header.cells;
+    image = data;
+    cellX = (const int *)(data + layout.cellX);
+    cellY = (const int *)(data + layout.cellY);
+    depths = (const double *)(data + layout.depths);
+    flowVectors = (const float *)(data + layout.flowVectors);
+    fileVelocities = (const double *)(data + layout.fileVelocities);
+    ioFlags = (const unsigned char *)(data + layout.ioFlags);
+    cellIndices = (const int *)(data + layout.cellIndices);
+}
+
+void HydroFile::copy(const HydroFile & other) {
+    clear();
+    if(!other.hydroFileLoaded) {
+        return;
+    }
+
+    //Text hydromaps own their image, which QByteArray shares rather than copies
+    cellData = other.cellData;
+    mappedFile = other.mappedFile;
+    setArrays(mappedFile ? other.image : cellData.constData());
+    hydroFileLoaded = true;
+}
+
+void HydroFile::move(HydroFile & other) {
+    clear();
+    if(!other.hydroFileLoaded) {
+        return;
+    }
+
+    //The arrays stay where they are, only the image changes hands
+    cellData = std::move(other.cellData);
+    mappedFile = std::move(other.mappedFile);
+    setArrays(mappedFile ? other.image : cellData.constData());
+    hydroFileLoaded = true;
+    other.clear();
+}
+
+void HydroFile::clear() {
+    hydroFileLoaded = false;
+    hydroMapFileName = QString();
+    width = 0;
+    height = 0;
+    waterCellCount = 0;
+    maxFlow = 0;
+    maxDepth = 0;
+    hydroIndex = 0;
+
+    cells = 0;
+    image = NULL;
+    cellX = NULL;
+    cellY = NULL;
+    depths = NULL;
+    flowVectors = NULL;
+    fileVelocities = NULL;
+    ioFlags = NULL;
+    cellIndices = NULL;
+
+    cellData.clear();
+    mappedFile.clear();
 }
 
 void HydroFile::setHydroIndex(QString filename) {
@@ -1,20 +1,43 @@
 #ifndef HYDROFILE_H
 #define HYDROFILE_H
 
+#include <QByteArray>
 #include <QColor>
 #include <QString>
 #include <QStringList>
 #include <QFile>
-#include <QHash>
 #include <QImage>
 #include <QRgb>
 #include <QPoint>
+#include <QSharedPointer>
 #include <QVector2D>
 #include <QVector>
+#include <utility>
 #include "grid.h"
 #include "constants.h"
 #include "riveriofile.h"
 
+//Bump whenever the layout of binary hydromaps changes
+#define HYDRO_FILE_VERSION 2
+
+//Bits of HydroFile::getIOFlags()
+#define HYDRO_FILE_INPUT 1
+#define HYDRO_FILE_OUTPUT 2
+
+//Text hydromaps are parsed by several threads once they are at least this many bytes per thread
+#define HYDRO_FILE_PARSE_CHUNK_BYTES (1 << 20)
+
+/**
+ * @brief The HydroFile class holds the depth and flow of every water cell of a hydromap.
+ *
+ *        Hydromaps are loaded either from the text files exported from NetLogo or from
+ *        binary hydromaps written by writeBinaryFile(), which are memory-mapped and used
+ *        in place.  Text hydromaps are converted to the same layout in memory once parsed.
+ *
+ *        Water cells are numbered by x and then y.  Lookups by coordinate go through a
+ *        dense grid of cell numbers, and the get*s() accessors return whole arrays
+ *        indexed by cell number for code that walks every cell.
+ */
 class HydroFile {
     public:
         /**
@@ -22,16 +45,90 @@ class HydroFile {
          * @param[in] filename The name of the file to load
          * @param[in] riverIOFile File specifying the inputs and output of the river.
          */
-        HydroFile(QString filename, RiverIOFile riverIOFile);
+        HydroFile(QString filename, const RiverIOFile & riverIOFile);
         HydroFile();
+        HydroFile(const HydroFile & other);
+        HydroFile & operator=(const HydroFile & rhs);
+        ~HydroFile();
+
+        /**
+         * @brief Move construction and assignment take the other hydromap's image and
+         *        leave it unloaded
+         */
+        HydroFile(HydroFile && other);
+        HydroFile & operator=(HydroFile && rhs);
 
         /**
          * @brief Loads the current hydroFile using a file, only if not previously initialized.
-         * Otherwise, this function does nothing.
+         * Otherwise, this function does nothing.  Binary hydromaps are mapped and keep the
+         * inputs and outputs they were converted with, riverIOFile is only used for text.
          * @param[in] filename The name of the file to load
          * @param[in] riverIOFile File specifying the inputs and output of the river.
          */
-        void loadFromFile(QString filename, RiverIOFile riverIOFile);
+        void loadFromFile(QString filename, const RiverIOFile & riverIOFile);
+
+        /**
+         * @brief Saves the hydromap as a binary hydromap, which is how text hydromaps are
+         *        converted.  The file is only valid on machines with the same byte order.
+         * @param[in] filename The file to write
+         * @return False if the hydromap is not loaded or the file could not be written
+         */
+        bool writeBinaryFile(const QString & filename) const;
+
+        /**
+         * @brief Replaces this hydromap with a memory-mapped binary hydromap.
+         * @param[in] filename The binary hydromap to map
+         * @return False, leaving this hydromap as it was, if the file is not a binary
+         *         hydromap of the current version
+         */
+        bool mapBinaryFile(const QString & filename);
+
+        /**
+         * @brief Returns the number of water cells
+         */
+        int getCellCount() const;
+
+        /**
+         * @brief Returns the number of the water cell at the given (x,y) coordinate
+         * @return The cell number, or -1 if there is no water cell there
+         */
+        int getCellIndex(int x, int y) const;
+
+        /**
+         * @brief Returns the number of every cell of the map, y * width + x, with -1 where
+         *        there is no water cell
+         */
+        const int * getCellIndices() const;
+
+        /**
+         * @brief Returns the x coordinate of every water cell
+         */
+        const int * getCellX() const;
+
+        /**
+         * @brief Returns the y coordinate of every water cell
+         */
+        const int * getCellY() const;
+
+        /**
+         * @brief Returns the depth of every water cell
+         */
+        const double * getDepths() const;
+
+        /**
+         * @brief Returns the flow vector of every water cell, x and y interleaved
+         */
+        const float * getFlowVectors() const;
+
+        /**
+         * @brief Returns the velocity reported in the hydrofile for every water cell
+         */
+        const double * getFileVelocities() const;
+
+        /**
+         * @brief Returns the HYDRO_FILE_INPUT and HYDRO_FILE_OUTPUT bits of every water cell
+         */
+        const unsigned char * getIOFlags() const;
 
         /**
          * @brief Checks if a water cell exists at the given (x,y) coordinate
@@ -52,7 +149,7 @@ class HydroFile {
          * @param[in] x The x coordinate
          * @param[in] y The y coordinate
          */
-        const QVector2D & getVector(int x, int y);
+        QVector2D getVector(int x, int y);
 
         /**
          * @brief Gets the velocity reported in hydrofile file. May be incorrect.
@@ -79,6 +176,11 @@ class HydroFile {
          */
         int getHydroIndex() const;
 
+        /**
+         * @brief Returns the name of the file this hydromap was loaded from
+         */
+        QString getFileName() const;
+
         /**
          * @brief isInput Signifies whether the specified cell is an input.
          * @param x X Coordinate
@@ -102,6 +204,7 @@ class HydroFile {
         QImage generateVisualization(int imageCellSize);
 
     private:
+        //One parsed cell of a text hydromap
         struct HydroData {
             int x;
             int y;
@@ -127,9 +230,35 @@ class HydroFile {
 
 
         /**
-         * @brief Reads the datafile to determine the dimension of the map.
+         * @brief Parses the cells of a hydromap straight out of the file's bytes.  The
+         *        header row is skipped and cells may be separated by any whitespace.
+         *
+         *        Large files are split into chunks on whitespace and parsed in parallel.
+         *        The tokens of each chunk are counted first so that every chunk knows which
+         *        of its tokens starts a cell.
+         * @param[in] begin First byte of the file
+         * @param[in] end One past the last byte of the file
+         * @param[out] records One entry per cell, in file order
+         */
+        void parseRecords(const char * begin, const char * end, QVector<HydroData> & records) const;
+
+        /**
+         * @brief Parses the cells whose first value lies in one chunk of the file.  The
+         *        last of them may continue into the following chunks.
+         * @param[in] chunkBegin First byte of the chunk
+         * @param[in] chunkEnd One past the last byte of the chunk
+         * @param[in] end One past the last byte of the file
+         * @param[in] firstToken Number of values in the file before the chunk, counting
+         *        the header row
+         * @param[out] records One entry per cell, in file order
+         */
+        void parseChunk(const char * chunkBegin, const char * chunkEnd, const char * end,
+                        qint64 firstToken, QVector<HydroData> & records) const;
+
+        /**
+         * @brief Uses the parsed cells to determine the dimension of the map.
          */
-        void setMapSize(QStringList & hydroFileData);
+        void setMapSize(const QVector<HydroData> & records);
 
         /**
          * @brief setHydroFileIndex The input values for the river are stored in vectors in the config.
@@ -143,14 +272,36 @@ class HydroFile {
          */
         void zeroHydroData(Grid<HydroData> & hydroData);
 
-        QVector<HydroData> hydroDataSet;
-        QHash<int, int> hydroDataSetIndices;
+        /**
+         * @brief Points the cell arrays at a binary hydromap and reads its header.
+         * @param[in] data First byte of the hydromap, in cellData or a mapped file
+         */
+        void setArrays(const char * data);
+
+        void copy(const HydroFile & other);
+        void move(HydroFile & other);
+        void clear();
+
+        //Water cells, ordered by x and then y.  The arrays point into image.
+        int cells;
+        const char * image;
+        const int * cellX;
+        const int * cellY;
+        const double * depths;
+        const float * flowVectors;      ///< x and y of each cell's flow vector
+        const double * fileVelocities;
+        const unsigned char * ioFlags;
+        const int * cellIndices;        ///< width * height cell numbers, -1 for land
+
+        QByteArray cellData;            ///< image of a text hydromap after parsing
+        QSharedPointer<QFile> mappedFile;   ///< set when image is a mapped binary hydromap
+
         int getHashKey(int x, int y) const;
 
         /**
-         * @brief Returns an entire cell's data at the given (x,y) coordinate.
+         * @brief Returns the index of a cell's data at the given (x,y) coordinate.
          */
-        HydroData & getData(int x, int y);
+        int getIndex(int x, int y) const;
 };
 
 #endif
@@ -1,18 +1,49 @@
 #include "hydrofiledict.h"
 
 #include <iostream>
+#include <omp.h>
 using std::cout;
 using std::endl;
 
-HydroFileDict::HydroFileDict(QStringList newFilenames)
+namespace {
+    //TODO Move IO data to hydrofiles or move file selection to GUI
+    QString getRiverIOFilename() {
+        return QDir::currentPath().append("/data/inputsoutputs.txt");
+    }
+}
+
+HydroFlowLoader::HydroFlowLoader(HydroFileDict * newHydroFileDict) {
+    hydroFileDict = newHydroFileDict;
+}
+
+void HydroFlowLoader::run() {
+    hydroFileDict->loadRemainingFlows();
+}
+
+HydroFileDict::HydroFileDict(QStringList newFilenames, const Configuration & config)
 {
+    stopLoading = false;
+    flowLoader = NULL;
+    load(newFilenames, config);
+}
+
+void HydroFileDict::load(QStringList newFilenames, const Configuration & config)
+{
+    clear();
+
     newFilenames.removeDuplicates();
     filenames = newFilenames;
+    flowPrecomputeDepth = config.flowPrecomputeDepth;
+    flowTrimMassFraction = config.flowTrimMassFraction;
+    flowMemoryBudget = (size_t)config.flowMemoryBudget * 1024 * 1024;
 
-    //TODO Move IO data to hydrofiles or move file selection to GUI
-    RiverIOFile riverIOFile(QDir::currentPath().append("/data/inputsoutputs.txt"));
+    QString riverIOFilename = getRiverIOFilename();
+    RiverIOFile riverIOFile(riverIOFilename);
+
+    FlowMapCache flowMapCache(QDir::currentPath().append("/results/cache"), riverIOFilename);
 
-#pragma omp parallel for
+    //With fewer hydrofiles than threads each one is parsed by all of them instead
+#pragma omp parallel for if(filenames.size() >= omp_get_max_threads())
     for(int i = 0; i < filenames.size(); i++)
     {
         QString filename;
@@ -24,14 +55,7 @@ HydroFileDict::HydroFileDict(QStringList newFilenames)
 
 
         HydroData * newHydroData = new HydroData;
-        newHydroData->hydroFile = HydroFile(filename, riverIOFile);
-
-
-        #pragma omp critical
-        cout << "Precomputing flows for: " << filename.toStdString() << endl;
-
-        newHydroData->carbonFlowMap =
-                CarbonFlowMap(&newHydroData->hydroFile, ITERATIONS_TO_PRECOMPUTE_FLOWS);
+        flowMapCache.getHydroFile(filename, riverIOFile, newHydroData->hydroFile);
 
         #pragma omp critical
         dict.insert(filename, newHydroData);
@@ -40,13 +64,258 @@ HydroFileDict::HydroFileDict(QStringList newFilenames)
     maxWidth = computeMaxWidth();
     maxHeight = computeMaxHeight();
 
+    //Number the patches once for every hydromap and store each one over that numbering
+    QVector<const HydroFile *> hydroFiles;
+    for(int i = 0; i < filenames.size(); i++) {
+        hydroFiles.append(&dict[filenames[i]]->hydroFile);
+    }
+    geometry = HydroGeometry(maxWidth, maxHeight, hydroFiles);
+
+    #pragma omp parallel for
+    for(int i = 0; i < filenames.size(); i++) {
+        HydroData * hydroData = dict[filenames[i]];
+        hydroData->patchHydroData = PatchHydroData(hydroData->hydroFile, geometry);
+    }
+
+    //The simulation can start as soon as the first hydrofile's flows are ready
+    resetFlowCache();
+    if(filenames.isEmpty()) {
+        return;
+    }
+
+    loadFlows(filenames[0], flowSchedule[0]);
+    setFlowsReady(0);
+
+    if(filenames.size() > 1) {
+        flowLoader = new HydroFlowLoader(this);
+        flowLoader->start();
+    }
 }
 
-HydroFileDict::HydroFileDict(){
+void HydroFileDict::resetFlowCache() {
+    flowSchedule.clear();
+    for(int i = 0; i < filenames.size(); i++) {
+        flowSchedule.append(dict[filenames[i]]);
+    }
+    flowStates.fill(FLOWS_RELEASED, filenames.size());
+    flowBytes.fill(0, filenames.size());
+    flowOperatorBytes.fill(0, filenames.size());
+    flowLastUsed.fill(0, filenames.size());
+    flowUses = 0;
+    flowCacheHits = 0;
+    flowCacheMisses = 0;
+    flowCacheEvictions = 0;
+    stopLoading = false;
+}
+
+void HydroFileDict::loadFlows(const QString & filename, HydroData * hydroData) const {
+    FlowMapCache flowMapCache(QDir::currentPath().append("/results/cache"), getRiverIOFilename());
+    int remainderIterations = FLOW_ITERATIONS_PER_HOUR % flowPrecomputeDepth;
+
+    bool cached = flowMapCache.getCarbonFlowMap(filename, &hydroData->hydroFile,
+                                                flowPrecomputeDepth,
+                                                flowTrimMassFraction,
+                                                hydroData->carbonFlowMap);
+    if(remainderIterations > 0) {
+        cached = flowMapCache.getCarbonFlowMap(filename, &hydroData->hydroFile,
+                                               remainderIterations,
+                                               flowTrimMassFraction,
+                                               hydroData->remainderFlowMap) && cached;
+    }
+
+    QMutexLocker locker(&flowMutex);
+    if(cached) {
+        cout << "Loaded cached flows for: " << filename.toStdString() << endl;
+    } else {
+        cout << "Precomputed flows for: " << filename.toStdString() << endl;
+    }
+    printTrimReport("step", hydroData->carbonFlowMap);
+    if(remainderIterations > 0) {
+        printTrimReport("remainder", hydroData->remainderFlowMap);
+    }
+}
+
+void HydroFileDict::loadRemainingFlows() {
+    for(int i = 1; i < flowSchedule.size(); i++) {
+        QMutexLocker locker(&flowMutex);
+        //Flows past the budget would only be released again before they are used
+        if(stopLoading || (flowMemoryBudget > 0 && getResidentBytes() >= flowMemoryBudget)) {
+            return;
+        }
+        if(flowStates.at(i) != FLOWS_RELEASED) {
+            continue;
+        }
+        flowStates[i] = FLOWS_LOADING;
+        locker.unlock();
+
+        loadFlows(filenames.at(i), flowSchedule.at(i));
+
+        locker.relock();
+        setFlowsReady(i);
+    }
+}
+
+void HydroFileDict::setFlowsReady(int index) {
+    HydroData * hydroData = flowSchedule[index];
+    flowStates[index] = FLOWS_READY;
+    flowBytes[index] = hydroData->carbonFlowMap.getBytes() + hydroData->remainderFlowMap.getBytes();
+    flowLastUsed[index] = ++flowUses;
+    flowStateChanged.wakeAll();
+}
+
+bool HydroFileDict::hasFlows(const QString & filename) const {
+    return hasFlows(dict.value(filename, NULL));
+}
+
+bool HydroFileDict::hasFlows(const HydroData * hydroData) const {
+    QMutexLocker locker(&flowMutex);
+    int index = flowSchedule.indexOf((HydroData *)hydroData);
+    return index >= 0 && flowStates[index] == FLOWS_READY;
+}
+
+HydroData * HydroFileDict::waitForFlows(const QString & filename) {
+    int index = filenames.indexOf(filename);
+    if(index < 0) {
+        return dict[filename];
+    }
+
+    QMutexLocker locker(&flowMutex);
+    if(flowStates[index] == FLOWS_READY) {
+        flowCacheHits++;
+    } else {
+        flowCacheMisses++;
+        while(flowStates[index] == FLOWS_LOADING) {
+            flowStateChanged.wait(&flowMutex);
+        }
+    }
+
+    //Released flows are reloaded from the flow map cache or precomputed again
+    if(flowStates[index] == FLOWS_RELEASED) {
+        flowStates[index] = FLOWS_LOADING;
+        locker.unlock();
+        loadFlows(filenames[index], flowSchedule[index]);
+        locker.relock();
+        setFlowsReady(index);
+    }
 
+    flowLastUsed[index] = ++flowUses;
+    releaseFlows(index);
+    return flowSchedule[index];
+}
+
+void HydroFileDict::setFlowOperatorBytes(const HydroData * hydroData, size_t bytes) {
+    QMutexLocker locker(&flowMutex);
+    int index = flowSchedule.indexOf((HydroData *)hydroData);
+    if(index >= 0) {
+        flowOperatorBytes[index] = bytes;
+    }
+}
+
+void HydroFileDict::setFlowMemoryBudget(size_t bytes) {
+    QMutexLocker locker(&flowMutex);
+    flowMemoryBudget = bytes;
+}
+
+void HydroFileDict::waitForFlowLoader() const {
+    if(flowLoader != NULL) {
+        flowLoader->wait();
+    }
+}
+
+size_t HydroFileDict::getResidentBytes() const {
+    size_t bytes = 0;
+    for(int i = 0; i < flowStates.size(); i++) {
+        bytes += flowBytes[i] + flowOperatorBytes[i];
+    }
+    return bytes;
+}
+
+void HydroFileDict::releaseFlows(int keep) {
+    while(flowMemoryBudget > 0 && getResidentBytes() > flowMemoryBudget) {
+        int oldest = -1;
+        for(int i = 0; i < flowStates.size(); i++) {
+            if(i != keep && flowStates[i] == FLOWS_READY
+                    && (oldest < 0 || flowLastUsed[i] < flowLastUsed[oldest]))
+            {
+                oldest = i;
+            }
+        }
+        if(oldest < 0) {
+            return;
+        }
+
+        HydroData * hydroData = flowSchedule[oldest];
+        hydroData->carbonFlowMap = CarbonFlowMap();
+        hydroData->remainderFlowMap = CarbonFlowMap();
+        flowStates[oldest] = FLOWS_RELEASED;
+        flowBytes[oldest] = 0;
+        //The flow operators still count until their owner sees the flows are gone, frees
+        //them and clears their bytes
+        flowCacheEvictions++;
+    }
+}
+
+FlowCacheStats HydroFileDict::getFlowCacheStats() const {
+    QMutexLocker locker(&flowMutex);
+    FlowCacheStats stats;
+    stats.hits = flowCacheHits;
+    stats.misses = flowCacheMisses;
+    stats.evictions = flowCacheEvictions;
+    stats.residentBytes = getResidentBytes();
+    stats.budgetBytes = flowMemoryBudget;
+    return stats;
+}
+
+void HydroFileDict::printFlowCacheReport() const {
+    FlowCacheStats stats = getFlowCacheStats();
+    cout << "Flow cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+         << stats.evictions << " evictions, " << stats.residentBytes / (1024.0 * 1024.0) << " MB resident";
+    if(stats.budgetBytes > 0) {
+        cout << " of " << stats.budgetBytes / (1024 * 1024) << " MB";
+    }
+    cout << endl;
+}
+
+void HydroFileDict::stopFlowLoader() {
+    if(flowLoader == NULL) {
+        return;
+    }
+
+    flowMutex.lock();
+    stopLoading = true;
+    flowMutex.unlock();
+
+    flowLoader->wait();
+    delete flowLoader;
+    flowLoader = NULL;
+}
+
+void HydroFileDict::printTrimReport(const char * name, const CarbonFlowMap & carbonFlowMap) const {
+    double totalMass = carbonFlowMap.getTotalMass();
+    if(totalMass <= 0.0) {
+        return;
+    }
+
+    cout << "    " << name << " flows: trimming dropped "
+         << 100.0 * carbonFlowMap.getTrimmedMass() / totalMass
+         << "% of the flowing carbon, " << 100.0 * carbonFlowMap.getLostMass() / totalMass
+         << "% is lost" << endl;
+}
+
+HydroFileDict::HydroFileDict(){
+    maxWidth = 0;
+    maxHeight = 0;
+    flowPrecomputeDepth = ITERATIONS_TO_PRECOMPUTE_FLOWS;
+    flowTrimMassFraction = 0.0;
+    flowMemoryBudget = 0;
+    stopLoading = false;
+    flowLoader = NULL;
+    resetFlowCache();
 }
 
 HydroFileDict::HydroFileDict(const HydroFileDict &other) {
+    stopLoading = false;
+    flowLoader = NULL;
     copy(other);
 }
 
@@ -58,6 +327,20 @@ HydroFileDict & HydroFileDict::operator=(const HydroFileDict &rhs) {
     return *this;
 }
 
+HydroFileDict::HydroFileDict(HydroFileDict &&other) {
+    stopLoading = false;
+    flowLoader = NULL;
+    move(other);
+}
+
+HydroFileDict & HydroFileDict::operator=(HydroFileDict &&rhs) {
+    if(this != &rhs) {
+        clear();
+        move(rhs);
+    }
+    return *this;
+}
+
 HydroData * & HydroFileDict::operator[](const QString filename)
 {
     return dict[filename];
@@ -111,34 +394,27 @@ HydroFileDict::~HydroFileDict() {
     clear();
 }
 
-const Grid<bool> HydroFileDict::getPatchUsageGrid() const {
-    int width = getMaxWidth();
-    int height = getMaxHeight();
-
-    Grid<bool> patchUsage(width, height);
-    for (int x = 0; x < width; x++) {
-        for (int y = 0; y < height; y++) {
-            patchUsage.set(x,y,false);
-            for(int i = 0; i < filenames.size(); i++) {
-                QString filename = filenames[i];
-                if (dict[filename]->hydroFile.patchExists(x,y)) {
-                    patchUsage.set(x,y,true);
-                    continue;
-                }
-            }
-        }
-    }
-
-    return patchUsage;
+const HydroGeometry & HydroFileDict::getGeometry() const {
+    return geometry;
 }
 
 void HydroFileDict::clear() {
+    stopFlowLoader();
+
     for( QHash<QString, HydroData *>::iterator i = dict.begin(); i != dict.end(); i++){
         delete *i;
     }
+    dict.clear();
+    filenames.clear();
+    resetFlowCache();
 }
 
 void HydroFileDict::copy(const HydroFileDict &rhs) {
+    //Copies are taken once the background precompute is done
+    if(rhs.flowLoader != NULL) {
+        rhs.flowLoader->wait();
+    }
+
     filenames = QStringList(rhs.filenames);
     for(int i = 0; i < filenames.size(); i++) {
         QString filename = filenames[i];
@@ -150,4 +426,55 @@ void HydroFileDict::copy(const HydroFileDict &rhs) {
 
     maxHeight = rhs.maxHeight;
     maxWidth = rhs.maxWidth;
+    geometry = rhs.geometry;
+
+    flowPrecomputeDepth = rhs.flowPrecomputeDepth;
+    flowTrimMassFraction = rhs.flowTrimMassFraction;
+    flowMemoryBudget = rhs.flowMemoryBudget;
+    resetFlowCache();
+    flowStates = rhs.flowStates;
+    flowBytes = rhs.flowBytes;
+    flowLastUsed = rhs.flowLastUsed;
+    flowUses = rhs.flowUses;
+    flowCacheHits = rhs.flowCacheHits;
+    flowCacheMisses = rhs.flowCacheMisses;
+    flowCacheEvictions = rhs.flowCacheEvictions;
+}
+
+void HydroFileDict::move(HydroFileDict &rhs) {
+    //The background precompute works on rhs, so it is stopped and picked up again here
+    bool wasLoading = rhs.flowLoader != NULL;
+    rhs.stopFlowLoader();
+
+    //The HydroData pointers change hands, so pointers callers hold into them stay valid
+    filenames = rhs.filenames;
+    dict = rhs.dict;
+    rhs.filenames.clear();
+    rhs.dict.clear();
+
+    maxHeight = rhs.maxHeight;
+    maxWidth = rhs.maxWidth;
+    geometry = std::move(rhs.geometry);
+    rhs.maxHeight = 0;
+    rhs.maxWidth = 0;
+
+    flowPrecomputeDepth = rhs.flowPrecomputeDepth;
+    flowTrimMassFraction = rhs.flowTrimMassFraction;
+    flowMemoryBudget = rhs.flowMemoryBudget;
+    flowSchedule = rhs.flowSchedule;
+    flowStates = rhs.flowStates;
+    flowBytes = rhs.flowBytes;
+    flowOperatorBytes = rhs.flowOperatorBytes;
+    flowLastUsed = rhs.flowLastUsed;
+    flowUses = rhs.flowUses;
+    flowCacheHits = rhs.flowCacheHits;
+    flowCacheMisses = rhs.flowCacheMisses;
+    flowCacheEvictions = rhs.flowCacheEvictions;
+    stopLoading = false;
+    rhs.resetFlowCache();
+
+    if(wasLoading && flowStates.contains(FLOWS_RELEASED)) {
+        flowLoader = new HydroFlowLoader(this);
+        flowLoader->start();
+    }
 }
@@ -3,25 +3,77 @@
 
 #include <QDir>
 #include <QHash>
+#include <QMutex>
 #include <QString>
 #include <QStringList>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
 #include "hydrofile.h"
 #include "carbonflowmap.h"
+#include "configuration.h"
+#include "flowmapcache.h"
 #include "hydrodata.h"
-#include "grid.h"
+#include "hydrogeometry.h"
+#include "patchhydrodata.h"
 #include "riveriofile.h"
 
+class HydroFileDict;
+
+/**
+ * @brief How well a HydroFileDict's flows fit its memory budget
+ */
+struct FlowCacheStats {
+    int hits;               ///< hydrofiles whose flows were in memory when used
+    int misses;             ///< hydrofiles whose flows were loaded or waited for when used
+    int evictions;          ///< times a hydrofile's flows were released to fit the budget
+    size_t residentBytes;   ///< flows and flow operators currently held
+    size_t budgetBytes;     ///< 0 if unlimited
+};
+
+/**
+ * @brief The HydroFlowLoader class precomputes the flows of a HydroFileDict's hydrofiles
+ *        on a background thread.  See HydroFileDict::load.
+ */
+class HydroFlowLoader : public QThread {
+    public:
+        HydroFlowLoader(HydroFileDict * newHydroFileDict);
+
+    protected:
+        void run();
+
+    private:
+        HydroFileDict * hydroFileDict;
+};
+
 class HydroFileDict
 {
+    friend class HydroFlowLoader;
 
     public:
 
         /**
-         * @brief Constructor that initializes the unique set of hydrofiles and carbonFlowMaps
-         *    referenced in the QStringList
+         * @brief Constructor that loads the unique set of hydrofiles referenced in the
+         *    QStringList, see load()
          * @param newFilenames A complete list of hydrofiles used in this simulation.
+         * @param config Flow precompute settings used for every hydrofile
          */
-        HydroFileDict(QStringList newFilenames);
+        HydroFileDict(QStringList newFilenames, const Configuration & config);
+
+        /**
+         * @brief Loads the unique set of hydrofiles referenced in the QStringList and starts
+         *    precomputing their carbonFlowMaps.
+         *
+         *    Every hydrofile is loaded right away since the patches are numbered over all of
+         *    them.  Only the flows of the first hydrofile are precomputed before returning,
+         *    the rest are precomputed on a background thread in the order they are listed
+         *    until the flow memory budget is full.  Use waitForFlows() before using a
+         *    hydrofile's carbonFlowMaps.
+         * @param newFilenames A complete list of hydrofiles used in this simulation, in the
+         *    order they are run.
+         * @param config Flow precompute settings used for every hydrofile
+         */
+        void load(QStringList newFilenames, const Configuration & config);
 
         /**
          * @brief Default constructor.  Does nothing.
@@ -41,6 +93,20 @@ class HydroFileDict
          */
         HydroFileDict & operator=(const HydroFileDict &rhs);
 
+        /**
+         * @brief Move constructor.  Takes other's hydrofiles rather than copying them, and
+         *        carries on with any background precompute it had not finished.
+         * @param other HydroFileDict to move, left empty
+         */
+        HydroFileDict(HydroFileDict && other);
+
+        /**
+         * @brief Move assignment operator
+         * @param rhs HydroFileDict to move, left empty
+         * @return a reference to ourselves
+         */
+        HydroFileDict & operator=(HydroFileDict && rhs);
+
         /**
          * @brief Destructor
          */
@@ -60,6 +126,52 @@ class HydroFileDict
          */
         const HydroData * operator[](const QString filename) const;
 
+        /**
+         * @brief Returns true if the hydrofile's carbonFlowMaps are in memory
+         * @param filename A string indicating the hydrodata to check
+         */
+        bool hasFlows(const QString & filename) const;
+        bool hasFlows(const HydroData * hydroData) const;
+
+        /**
+         * @brief Marks the hydrofile as used and returns it once its carbonFlowMaps are in
+         *        memory, waiting for the background precompute or reloading them if they
+         *        were released.  Then releases the flows of the least recently used other
+         *        hydrofiles until the flow memory budget is met.
+         * @param filename A string indicating the hydrodata to access
+         * @return A pointer to the referenced hydrodata
+         */
+        HydroData * waitForFlows(const QString & filename);
+
+        /**
+         * @brief Records the memory of flow operators built from a hydrofile's flows so it
+         *        counts against the flow memory budget.  Callers release the operators once
+         *        hasFlows() is false and then set their bytes back to 0, until then they
+         *        count even though the flows were released.
+         */
+        void setFlowOperatorBytes(const HydroData * hydroData, size_t bytes);
+
+        /**
+         * @brief Replaces the flow memory budget the hydrofiles were loaded with, 0 for
+         *        unlimited.  It is met the next time waitForFlows() is called.
+         */
+        void setFlowMemoryBudget(size_t bytes);
+
+        /**
+         * @brief Waits for the background precompute started by load() to finish
+         */
+        void waitForFlowLoader() const;
+
+        /**
+         * @brief Returns the flow cache hits, misses and memory use so far
+         */
+        FlowCacheStats getFlowCacheStats() const;
+
+        /**
+         * @brief Prints getFlowCacheStats()
+         */
+        void printFlowCacheReport() const;
+
         /**
          * @brief Returns the max width of all the hydrofiles
          * @return max width of widest hydrofile
@@ -73,16 +185,78 @@ class HydroFileDict
         int getMaxHeight() const;
 
         /**
-         * @brief Iterates through all cells of all maps to find all patches used
-         * @return A Grid of booleans indicating the existance of a patch.
+         * @brief Returns the numbering of every patch used by any of the hydrofiles.  The
+         *        PatchHydroData of each hydrofile is stored over it.
          */
-        const Grid<bool> getPatchUsageGrid() const;
+        const HydroGeometry & getGeometry() const;
 
     private:
         QStringList filenames;
         QHash<QString, HydroData *> dict;
         int maxWidth;
         int maxHeight;
+        HydroGeometry geometry;
+
+        //What each hydrofile's flows are doing, indexed like filenames
+        enum FlowState {
+            FLOWS_RELEASED,
+            FLOWS_LOADING,
+            FLOWS_READY
+        };
+
+        int flowPrecomputeDepth;
+        double flowTrimMassFraction;
+        size_t flowMemoryBudget;
+        QVector<HydroData *> flowSchedule;
+        QVector<int> flowStates;
+        QVector<size_t> flowBytes;
+        QVector<size_t> flowOperatorBytes;
+        QVector<int> flowLastUsed;      ///< flowUses when last loaded or used
+        int flowUses;
+        int flowCacheHits;
+        int flowCacheMisses;
+        int flowCacheEvictions;
+        bool stopLoading;
+        HydroFlowLoader * flowLoader;
+        mutable QMutex flowMutex;
+        mutable QWaitCondition flowStateChanged;
+
+        /**
+         * @brief Precomputes the carbonFlowMaps of one hydrofile, from the cache if possible
+         */
+        void loadFlows(const QString & filename, HydroData * hydroData) const;
+
+        /**
+         * @brief Precomputes the flows of every hydrofile after the first, in order, until
+         *        the budget is full.  Run by the HydroFlowLoader.
+         */
+        void loadRemainingFlows();
+
+        /**
+         * @brief Marks the flows of a hydrofile as loaded, the caller holds flowMutex
+         */
+        void setFlowsReady(int index);
+
+        /**
+         * @brief Returns the memory held by flows in memory, the caller holds flowMutex
+         */
+        size_t getResidentBytes() const;
+
+        /**
+         * @brief Releases the least recently used flows, other than those of keep, until
+         *        the budget is met.  The caller holds flowMutex.
+         */
+        void releaseFlows(int keep);
+
+        /**
+         * @brief Initializes the flow cache for the current filenames with nothing loaded
+         */
+        void resetFlowCache();
+
+        /**
+         * @brief Stops the background precompute after its current hydrofile
+         */
+        void stopFlowLoader();
 
         /**
          * @brief copy constructor helper
@@ -90,11 +264,24 @@ class HydroFileDict
          */
         void copy(const HydroFileDict &rhs);
 
+        /**
+         * @brief move constructor helper
+         * @param rhs HydroFileDict to move
+         */
+        void move(HydroFileDict &rhs);
+
         /**
          * @brief Destructor helper
          */
         void clear();
 
+        /**
+         * @brief Prints how much carbon trimming dropped from a flow map and how much of
+         *        it is lost rather than given back to its sources' other entries
+         * @param name Which of the hydromap's flow maps it is, step or remainder
+         */
+        void printTrimReport(const char * name, const CarbonFlowMap & carbonFlowMap) const;
+
         /**
          * @brief computeMaxWidth
          * @return The max width of all the hydroFiles.
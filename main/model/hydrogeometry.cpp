@@ -0,0 +1,60 @@
+#include "hydrogeometry.h"
+
+HydroGeometry::HydroGeometry() {
+    width = 0;
+    height = 0;
+}
+
+HydroGeometry::HydroGeometry(int newWidth, int newHeight, const QVector<const HydroFile *> & hydroFiles) {
+    width = newWidth;
+    height = newHeight;
+    patchIndices.fill(-1, width * height);
+
+    //Mark the cells of every hydromap, then number the marked patches
+    for(int i = 0; i < hydroFiles.size(); i++) {
+        const HydroFile * hydroFile = hydroFiles[i];
+        const int * cellX = hydroFile->getCellX();
+        const int * cellY = hydroFile->getCellY();
+        for(int cell = 0; cell < hydroFile->getCellCount(); cell++) {
+            patchIndices[cellX[cell] * height + cellY[cell]] = 0;
+        }
+    }
+
+    for(int x = 0; x < width; x++) {
+        for(int y = 0; y < height; y++) {
+            int & index = patchIndices[x * height + y];
+            if(index == 0) {
+                index = patchX.size();
+                patchX.append(x);
+                patchY.append(y);
+            }
+        }
+    }
+}
+
+int HydroGeometry::getWidth() const {
+    return width;
+}
+
+int HydroGeometry::getHeight() const {
+    return height;
+}
+
+int HydroGeometry::getSize() const {
+    return patchX.size();
+}
+
+int HydroGeometry::getIndex(int x, int y) const {
+    if(x < 0 || x >= width || y < 0 || y >= height) {
+        return -1;
+    }
+    return patchIndices[x * height + y];
+}
+
+const int * HydroGeometry::getPatchX() const {
+    return patchX.constData();
+}
+
+const int * HydroGeometry::getPatchY() const {
+    return patchY.constData();
+}
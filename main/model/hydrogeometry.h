@@ -0,0 +1,62 @@
+#ifndef HYDROGEOMETRY_H
+#define HYDROGEOMETRY_H
+
+#include <QVector>
+
+#include "hydrofile.h"
+
+/**
+ * @brief The HydroGeometry class numbers the patches of the union of a set of hydromaps.
+ *
+ *        Every hydromap of a simulation covers part of the same domain, so the patches are
+ *        numbered once for all of them, by x and then y.  Per-hydromap data is then kept
+ *        as dense arrays over these numbers and only one full-size index grid is needed.
+ */
+class HydroGeometry {
+    public:
+        /**
+         * @brief Default constructor, creates an empty geometry
+         */
+        HydroGeometry();
+
+        /**
+         * @brief Numbers every patch that is water in at least one of the hydromaps
+         * @param width Width of the domain, at least the width of every hydromap
+         * @param height Height of the domain, at least the height of every hydromap
+         * @param hydroFiles The hydromaps of the simulation
+         */
+        HydroGeometry(int width, int height, const QVector<const HydroFile *> & hydroFiles);
+
+        int getWidth() const;
+        int getHeight() const;
+
+        /**
+         * @brief Returns the number of patches
+         */
+        int getSize() const;
+
+        /**
+         * @brief Returns the number of the patch at the given (x,y) coordinate
+         * @return The patch number, or -1 if no hydromap has water there
+         */
+        int getIndex(int x, int y) const;
+
+        /**
+         * @brief Returns the x coordinate of every patch
+         */
+        const int * getPatchX() const;
+
+        /**
+         * @brief Returns the y coordinate of every patch
+         */
+        const int * getPatchY() const;
+
+    private:
+        int width;
+        int height;
+        QVector<int> patchX;
+        QVector<int> patchY;
+        QVector<int> patchIndices;  ///< width * height patch numbers, x * height + y
+};
+
+#endif // HYDROGEOMETRY_H
@@ -0,0 +1,11 @@
+#include "hydrotransition.h"
+
+HydroTransition::HydroTransition(const PatchHydroData & from, const PatchHydroData & to) {
+    for(int i = 0; i < to.depth.size(); i++) {
+        if(from.depth[i] > 0.0 && to.depth[i] == 0.0) {
+            dryingPatches.append(i);
+        } else if(from.depth[i] == 0.0 && to.depth[i] > 0.0) {
+            wettingPatches.append(i);
+        }
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef HYDROTRANSITION_H
+#define HYDROTRANSITION_H
+
+#include <QVector>
+
+#include "patchhydrodata.h"
+
+/**
+ * @brief The HydroTransition class lists the patches whose water changes when the river
+ *        switches from one hydromap to another.
+ */
+class HydroTransition {
+    public:
+        /**
+         * @brief Compares the depth of every patch under the two hydromaps
+         * @param from The hydromap the river is leaving
+         * @param to The hydromap the river is switching to
+         */
+        HydroTransition(const PatchHydroData & from, const PatchHydroData & to);
+
+        QVector<int> dryingPatches;     ///< water -> land
+        QVector<int> wettingPatches;    ///< land -> water
+};
+
+#endif // HYDROTRANSITION_H
@@ -3,9 +3,12 @@
 
 #include <QVector>
 #include <QHash>
+#include <utility>
 #include "configuration.h"
 #include "hydrofiledict.h"
+#include "hydrogeometry.h"
 #include "grid.h"
+#include "stockview.h"
 #include "utility.h"
 
 /**
@@ -33,6 +36,19 @@ class PatchCollection {
          */
         PatchCollection & operator=(const PatchCollection & rhs);
 
+        /**
+         * @brief Move constructor, takes other's arrays and leaves it empty
+         * @param other PatchCollection to move
+         */
+        PatchCollection(PatchCollection && other);
+
+        /**
+         * @brief Move assignment operator
+         * @param rhs PatchCollection to move
+         * @return Reference to this object
+         */
+        PatchCollection & operator=(PatchCollection && rhs);
+
         /**
          * @brief Destructor
          */
@@ -69,6 +85,54 @@ class PatchCollection {
          */
         int getSize() const;
 
+        /**
+         * @brief Provides the indices of the patches with water, in increasing order.
+         *        Input patches always have water so these are every patch the hourly
+         *        update processes.  Iterate these instead of checking hasWater.
+         */
+        const QVector<int> & getActivePatches() const;
+
+        /**
+         * @brief Provides the indices of the river input patches, in increasing order
+         */
+        const QVector<int> & getInputPatches() const;
+
+        /**
+         * @brief Sets the active and input patches of the current hydromap, done by
+         *        PatchHydroData::apply along with the rest of the hydro data
+         */
+        void setActivePatches(const QVector<int> & newActivePatches, const QVector<int> & newInputPatches);
+
+        /**
+         * @brief Swaps flowStocks with flowStocksBuffer and re-points the DOC, POC,
+         *        waterdecomp and phyto views at the new current buffer.
+         */
+        void swapFlowStocks();
+
+        /**
+         * @brief Indicates whether the per patch fluxes and limitations are kept, which is
+         *        only when Configuration::saveFluxes is set.  Otherwise they are NULL and
+         *        only the stocks and the hydro data are allocated.
+         */
+        bool hasFluxes() const;
+
+        /**
+         * @brief Provides the number of flux and limitation arrays
+         */
+        static int getFluxCount();
+
+        /**
+         * @brief Provides the name of a flux or limitation array
+         * @param flux 0 to getFluxCount() - 1
+         */
+        static const char * getFluxName(int flux);
+
+        /**
+         * @brief Provides a flux or limitation array, NULL unless hasFluxes()
+         * @param flux 0 to getFluxCount() - 1
+         */
+        const double * getFlux(int flux) const;
+
 
         int * pxcor;             ///< the x_coordinate for the patch
         int * pycor;             ///< the y_coordinate for the patch
@@ -76,6 +140,7 @@ class PatchCollection {
         double * flowY;          ///< flow vector in the y_direction for hydraulics
         double * flowMagnitude;  ///< the rate of flow for hydraulics
         double * depth;          ///< depth of the water
+        double * lightAttenuation; ///< fraction of the light reaching the bottom, see PatchHydroData
         bool * hasWater;         ///< indicates whether or not the patch has water
 
         bool * isInput;          //Indicates whether the water flows into the river at this cell
@@ -85,6 +150,9 @@ class PatchCollection {
 
         int * aqa_point;        ///< biomass estimates of macro from USGS
 
+        //Arrays that are only read and written within an hour's processing are fluxes and
+        //limitations, NULL unless hasFluxes().  See FLUX_ARRAYS in patchcollection.cpp.
+
         double * waterdecomp_doc_prey_limitation;       ///< NOT AVAILABLE
         double * waterdecomp_poc_prey_limitation;       ///< NOT AVAILABLE
         double * peri_doc_prey_limitation;              ///< NOT AVAILABLE
@@ -108,18 +176,21 @@ class PatchCollection {
 
         double * assimilation;                       ///< NOT AVAILABLE
         double * detritus;                           ///< NOT AVAILABLE
-        double * DOC;                                ///< NOT AVAILABLE
-        double * POC;                                ///< NOT AVAILABLE
-        double * waterdecomp;                        ///< NOT AVAILABLE
+        StockView DOC;                               ///< NOT AVAILABLE, view into flowStocks
+        StockView POC;                               ///< NOT AVAILABLE, view into flowStocks
+        StockView waterdecomp;                       ///< NOT AVAILABLE, view into flowStocks
         double * seddecomp;                          ///< NOT AVAILABLE
         double * macro;                              ///< NOT AVAILABLE
-        double * phyto;                              ///< NOT AVAILABLE
+        StockView phyto;                             ///< NOT AVAILABLE, view into flowStocks
         double * herbivore;                          ///< NOT AVAILABLE
         double * sedconsumer;                        ///< NOT AVAILABLE
         double * peri;                               ///< NOT AVAILABLE
         double * consumer;                           ///< consumers in the water column, such as fish
         double * bottom_light;                    ///< par that reaches the bottom of the river
 
+        double * flowStocks;        ///< stocks moved by the flow, FLOW_STOCKS interleaved per patch
+        double * flowStocksBuffer;  ///< the flow writes here before the buffers are swapped
+
         double * consumer_consumption;              ///< NOT AVAILABLE
         double * consumer_ingest_herbivore;         ///< NOT AVAILABLE
         double * consumer_pred_herbivore;           ///< NOT AVAILABLE
@@ -230,18 +301,10 @@ class PatchCollection {
          */
         void initializePatches(Configuration & config, int newSize);
 
-        /**
-         * @brief Provides a key to use with the index map given an x and y coordinate
-         * @param x The x coordinate
-         * @param y The y coordinate
-         * @return The key for the indexMap
-         */
-        int getIndexMapKey(int x, int y) const;
-
         int size;
-        int width;
-        int height;
-        QHash<int,int> indexMap;
+        HydroGeometry geometry;     ///< numbers the patches, shared with the HydroFileDict
+        QVector<int> activePatches; ///< shared with the current hydromap's PatchHydroData
+        QVector<int> inputPatches;  ///< shared with the current hydromap's PatchHydroData
         Configuration config;
 
         /**
@@ -250,10 +313,21 @@ class PatchCollection {
          */
         void copy(const PatchCollection & other);
 
+        /**
+         * @brief move Move helper, takes other's arrays and leaves it empty
+         * @param other Other PatchCollection to move
+         */
+        void move(PatchCollection & other);
+
         /**
          * @brief Clears the object's memory
          */
         void clear();
+
+        /**
+         * @brief Points the DOC, POC, waterdecomp and phyto views at flowStocks
+         */
+        void updateStockViews();
 };
 
 #endif // PATCHCOLLECTION_H
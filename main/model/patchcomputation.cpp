@@ -1,23 +1,48 @@
 #include "patchcomputation.h"
 
-void PatchComputation::updatePatches(PatchCollection & p, const Configuration & config, int currPAR ) {
+PatchComputation::HourlyForcing PatchComputation::getHourlyForcing(const Configuration & config, int currPAR,
+                                                                   int currWaterTemp, double currGrowthRate)
+{
+    HourlyForcing forcing;
+    forcing.currPAR = currPAR;
+    forcing.currWaterTemp = currWaterTemp;
+    forcing.currGrowthRate = currGrowthRate;
+    forcing.turbidity = getTurbidity(config);
+
+    //TODO Ask Kevin what theta is and why it is 1.072.  I want to add
+    //it to the constants file but "THETA" is really ambiguous. -ECP
+    forcing.macroQ10 = pow(THETA, (currWaterTemp - config.macroTemp));
+
+    //base temperature for nominal growth
+    //TODO What is base temperature and why is it a magic number?
+    double base_temperature = 8.0;
+    forcing.phytoQ10 = pow(THETA, (currWaterTemp - base_temperature));
+
+    return forcing;
+}
+
+double PatchComputation::getTurbidity(const Configuration & config) {
+    // From 2011 team's update_patches function
+    double turbidity = TURBIDITY_YINTERCEPT + (TURBIDITY_SLOPE * config.tss);
+    Utility::boundLower(turbidity, 0.01);
+    return turbidity;
+}
+
+void PatchComputation::updatePatches(PatchCollection & p, const HourlyForcing & forcing) {
+    const QVector<int> & activePatches = p.getActivePatches();
     #pragma omp for
-    for(int i = 0; i < p.getSize(); i++) {
-        //Only process patches if they currently contain water
-        if(!p.hasWater[i] && !p.isInput[i]) {
-            //TODO: Augment detritus before continuing.
-            // (Once done, remove land->water detritus augmentation from river.cpp)
-            continue;
-        }
+    for(int n = 0; n < activePatches.size(); n++) {
+        //Only patches that currently contain water are processed
+        //TODO: Augment the land patches' detritus.
+        // (Once done, remove land->water detritus augmentation from river.cpp)
+        int i = activePatches[n];
 
         // From 2011 team's update_patches function
 
-        p.turbidity[i] = TURBIDITY_YINTERCEPT + (TURBIDITY_SLOPE * config.tss);
-        Utility::boundLower(p.turbidity[i], 0.01);
+        p.turbidity[i] = forcing.turbidity;
 
         //the amount of light that reaches the bottom of a water column
-        p.bottom_light[i] = currPAR
-                * exp( (-1 * p.depth[i]) * p.turbidity[i] );
+        p.bottom_light[i] = forcing.currPAR * p.lightAttenuation[i];
 
         //TODO why is this code altering the config? Config should never be edited by model. -ECP
         //Also these two do not ever get used.  Commenting them out for now.
@@ -33,21 +58,18 @@ void PatchComputation::updatePatches(PatchCollection & p, const Configuration &
     }
 }
 
-void PatchComputation::macro(PatchCollection & p, const Configuration & config, int currPAR, int currWaterTemp, double currGrowthRate) {
+void PatchComputation::macro(PatchCollection & p, const Configuration & config, const HourlyForcing & forcing) {
+    const QVector<int> & activePatches = p.getActivePatches();
     #pragma omp for
-    for(int i = 0; i < p.getSize(); i++) {
-        //Only process patches if they currently contain water
-        if(!p.hasWater[i] && !p.isInput[i]) {
-            continue;
-        }
+    for(int n = 0; n < activePatches.size(); n++) {
+        //Only patches that currently contain water are processed
+        int i = activePatches[n];
 
 
 
         // From 2011 team's go_macro function
 
-        //TODO Ask Kevin what theta is and why it is 1.072.  I want to add
-        //it to the constants file but "THETA" is really ambiguous. -ECP
-        double Q10 = pow(THETA, (currWaterTemp - config.macroTemp));
+        double Q10 = forcing.macroQ10;
 
         //TODO pull velocity from hydrofile rather than patches
         if(p.flowMagnitude[i] < config.macroVelocityMax) {
@@ -59,7 +81,7 @@ void PatchComputation::macro(PatchCollection & p, const Configuration & config,
             p.K[i] = 0.01;
         }
         //Same at bottom-light
-        double macro_light = currPAR * exp( (-1*p.depth[i]) * p.turbidity[i] );
+        double macro_light = forcing.currPAR * p.lightAttenuation[i];
 
         p.gross_photo_macro[i] = config.macroGross * p.macro[i]
                 * ( macro_light / ( macro_light + 10.0)) * Q10
@@ -72,7 +94,7 @@ void PatchComputation::macro(PatchCollection & p, const Configuration & config,
                 * (p.macro[i] / HOURS_PER_DAY);
 
         p.growth_macro[i] = (p.gross_photo_macro[i] - p.respiration_macro[i]
-                - p.senescence_macro[i] - p.scouring_macro[i]) * currGrowthRate;
+                - p.senescence_macro[i] - p.scouring_macro[i]) * forcing.currGrowthRate;
 
         p.macro[i] += p.growth_macro[i];
 
@@ -80,13 +102,12 @@ void PatchComputation::macro(PatchCollection & p, const Configuration & config,
     }
 }
 
-void PatchComputation::phyto(PatchCollection & p, const Configuration & config, int currPAR, int currWaterTemp) {
+void PatchComputation::phyto(PatchCollection & p, const Configuration & config, const HourlyForcing & forcing) {
+    const QVector<int> & activePatches = p.getActivePatches();
     #pragma omp for
-    for(int i = 0; i < p.getSize(); i++) {
-        //Only process patches if they currently contain water
-        if(!p.hasWater[i] && !p.isInput[i]) {
-            continue;
-        }
+    for(int n = 0; n < activePatches.size(); n++) {
+        //Only patches that currently contain water are processed
+        int i = activePatches[n];
 
 
 
@@ -96,10 +117,7 @@ void PatchComputation::phyto(PatchCollection & p, const Configuration & config,
         Utility::boundValue(p.phyto[i], 0.001, 900000.0);
 
 
-        //base temperature for nominal growth
-        //TODO What is base temperature and why is it a magic number?
-        double base_temperature = 8.0;
-        double Q10 = pow(THETA, (currWaterTemp - base_temperature));
+        double Q10 = forcing.phytoQ10;
         double km = 10; //half saturation constant
 
 
@@ -111,10 +129,10 @@ void PatchComputation::phyto(PatchCollection & p, const Configuration & config,
 
         p.respiration_phyto[i] = (config.phytoRespiration / HOURS_PER_DAY) * p.phyto[i] * Q10;
 
-        double pre_ln = 0.01 + currPAR
-                * exp(-1 * p.phyto[i] * config.kPhyto * p.depth[i]);
-        double be = km + currPAR
-                * exp(-1 * p.phyto[i] * config.kPhyto * p.depth[i]);
+        double pre_ln = 0.01 + forcing.currPAR
+                * PatchMath::exp(-1 * p.phyto[i] * config.kPhyto * p.depth[i]);
+        double be = km + forcing.currPAR
+                * PatchMath::exp(-1 * p.phyto[i] * config.kPhyto * p.depth[i]);
 
         //photosynthesis from phytoplankton derived from Huisman Weissing 1994
         p.gross_photo_phyto[i] = fabs(pre_ln / be) * (1.0 / p.depth[i])
@@ -127,12 +145,11 @@ void PatchComputation::phyto(PatchCollection & p, const Configuration & config,
 }
 
 void PatchComputation::herbivore(PatchCollection & p, const Configuration & config) {
+    const QVector<int> & activePatches = p.getActivePatches();
     #pragma omp for
-    for(int i = 0; i < p.getSize(); i++) {
-        //Only process patches if they currently contain water
-        if(!p.hasWater[i] && !p.isInput[i]) {
-            continue;
-        }
+    for(int n = 0; n < activePatches.size(); n++) {
+        //Only patches that currently contain water are processed
+        int i = activePatches[n];
 
 
 
@@ -177,12 +194,11 @@ void PatchComputation::herbivore(PatchCollection & p, const Configuration & conf
 }
 
 void PatchComputation::waterDecomp(PatchCollection & p, const Configuration & config) {
+    const QVector<int> & activePatches = p.getActivePatches();
     #pragma omp for
-    for(int i = 0; i < p.getSize(); i++) {
-        //Only process patches if they currently contain water
-        if(!p.hasWater[i] && !p.isInput[i]) {
-            continue;
-        }
+    for(int n = 0; n < activePatches.size(); n++) {
+        //Only patches that currently contain water are processed
+        int i = activePatches[n];
 
 
 
@@ -218,12 +234,11 @@ void PatchComputation::waterDecomp(PatchCollection & p, const Configuration & co
 }
 
 void PatchComputation::sedDecomp(PatchCollection & p, const Configuration & config) {
+    const QVector<int> & activePatches = p.getActivePatches();
     #pragma omp for
-    for(int i = 0; i < p.getSize(); i++) {
-        //Only process patches if they currently contain water
-        if(!p.hasWater[i] && !p.isInput[i]) {
-            continue;
-        }
+    for(int n = 0; n < activePatches.size(); n++) {
+        //Only patches that currently contain water are processed
+        int i = activePatches[n];
 
 
 
@@ -259,12 +274,11 @@ void PatchComputation::sedDecomp(PatchCollection & p, const Configuration & conf
 }
 
 void PatchComputation::sedConsumer(PatchCollection & p, const Configuration & config) {
+    const QVector<int> & activePatches = p.getActivePatches();
     #pragma omp for
-    for(int i = 0; i < p.getSize(); i++) {
-        //Only process patches if they currently contain water
-        if(!p.hasWater[i] && !p.isInput[i]) {
-            continue;
-        }
+    for(int n = 0; n < activePatches.size(); n++) {
+        //Only patches that currently contain water are processed
+        int i = activePatches[n];
 
 
 
@@ -311,12 +325,11 @@ void PatchComputation::sedConsumer(PatchCollection & p, const Configuration & co
 
 void PatchComputation::consumer(PatchCollection & p, const Configuration & config) {
 
+    const QVector<int> & activePatches = p.getActivePatches();
     #pragma omp for
-    for(int i = 0; i < p.getSize(); i++) {
-        //Only process patches if they currently contain water
-        if(!p.hasWater[i] && !p.isInput[i]) {
-            continue;
-        }
+    for(int n = 0; n < activePatches.size(); n++) {
+        //Only patches that currently contain water are processed
+        int i = activePatches[n];
 
 
 
@@ -352,12 +365,11 @@ void PatchComputation::consumer(PatchCollection & p, const Configuration & confi
 }
 
 void PatchComputation::DOC(PatchCollection & p, const Configuration & config){
+    const QVector<int> & activePatches = p.getActivePatches();
     #pragma omp for
-    for(int i = 0; i < p.getSize(); i++) {
-        //Only process patches if they currently contain water
-        if(!p.hasWater[i] && !p.isInput[i]) {
-            continue;
-        }
+    for(int n = 0; n < activePatches.size(); n++) {
+        //Only patches that currently contain water are processed
+        int i = activePatches[n];
 
 
 
@@ -382,12 +394,11 @@ void PatchComputation::DOC(PatchCollection & p, const Configuration & config){
 }
 
 void PatchComputation::POC(PatchCollection & p) {
+    const QVector<int> & activePatches = p.getActivePatches();
     #pragma omp for
-    for(int i = 0; i < p.getSize(); i++) {
-        //Only process patches if they currently contain water
-        if(!p.hasWater[i] && !p.isInput[i]) {
-            continue;
-        }
+    for(int n = 0; n < activePatches.size(); n++) {
+        //Only patches that currently contain water are processed
+        int i = activePatches[n];
 
 
 
@@ -396,7 +407,7 @@ void PatchComputation::POC(PatchCollection & p) {
         if(p.flowMagnitude[i] > 0.0)
         {
             // exchange between POC and detritus determined by an approximation of Stoke's Law
-            p.detritus_POC_transfer[i] = p.detritus[i] * (.25 * log10(((p.flowMagnitude[i] / 40.0 ) + .0001) + 1.0));
+            p.detritus_POC_transfer[i] = p.detritus[i] * (.25 * PatchMath::log10(((p.flowMagnitude[i] / 40.0 ) + .0001) + 1.0));
         }
         // cap at 100%. *need reference
         Utility::boundUpper(p.detritus_POC_transfer[i], 1.0);
@@ -412,18 +423,17 @@ void PatchComputation::POC(PatchCollection & p) {
 }
 
 void PatchComputation::detritus(PatchCollection & p, const Configuration & config) {
+    const QVector<int> & activePatches = p.getActivePatches();
     #pragma omp for
-    for(int i = 0; i < p.getSize(); i++) {
-        //Only process patches if they currently contain water
-        if(!p.hasWater[i] && !p.isInput[i]) {
-            continue;
-        }
+    for(int n = 0; n < activePatches.size(); n++) {
+        //Only patches that currently contain water are processed
+        int i = activePatches[n];
 
 
         // From 2011 team's go_detritus function
 
         if(p.flowMagnitude[i] > 0.0) {
-            p.POC_detritus_transfer[i] = p.POC[i] * (1.0 - (0.25 * log10((( p.flowMagnitude[i] / 40.0) + 0.0001) + 1.0)));
+            p.POC_detritus_transfer[i] = p.POC[i] * (1.0 - (0.25 * PatchMath::log10((( p.flowMagnitude[i] / 40.0) + 0.0001) + 1.0)));
         }
         Utility::boundLower(p.POC_detritus_transfer[i], 0.0);
 
@@ -493,7 +503,7 @@ void PatchComputation::predSedConsumer(PatchCollection & p, int i) {
 void PatchComputation::predDetritus(PatchCollection & p, int i) {
     // From 2011 team's pred_detritus function
     p.detritus_POC_transfer[i] = p.detritus[i]
-            * (0.25 * log10(p.flowMagnitude[i] / 40.0 + 0.01) + 0.5);
+            * (0.25 * PatchMath::log10(p.flowMagnitude[i] / 40.0 + 0.01) + 0.5);
     p.detritus[i] = p.detritus[i] + p.detritus_growth[i] - p.seddecomp_pred_detritus[i]
             - p.detritus_POC_transfer[i];
     Utility::boundLower(p.detritus[i], 0.001);
@@ -517,3 +527,397 @@ void PatchComputation::predConsum(PatchCollection & p, int i) {
             - (p.consumer_respiration[i] + p.consumer_excretion[i] + p.consumer_senescence[i]);
     Utility::boundLower(p.consumer[i], 0.001);
 }
+
+void PatchComputation::processPatchesReference(PatchCollection & p, const Configuration & config,
+                                               const HourlyForcing & forcing)
+{
+    updatePatches(p, forcing);
+    macro(p, config, forcing);
+    phyto(p, config, forcing);
+    herbivore(p, config);
+    waterDecomp(p, config);
+    sedDecomp(p, config);
+    sedConsumer(p, config);
+    consumer(p, config);
+    DOC(p, config);
+    POC(p);
+    detritus(p, config);
+
+    const QVector<int> & activePatches = p.getActivePatches();
+    #pragma omp for
+    for(int n = 0; n < activePatches.size(); n++) {
+        int i = activePatches[n];
+
+        predPhyto(p, i);
+        predHerbivore(p, i);
+        predSedDecomp(p, i);
+        predWaterDecomp(p, i);
+        predSedConsumer(p, i);
+        predDetritus(p, i);
+        predDOC(p, i);
+        predPOC(p, i);
+        predConsum(p, i);
+    }
+}
+
+void PatchComputation::processPatchesFused(PatchCollection & p, const Configuration & config,
+                                           const HourlyForcing & forcing)
+{
+    const PatchMath::Kernels & math = PatchMath::selected();
+
+    //Only patches that currently contain water are processed, in equal blocks of them
+    const QVector<int> & activePatches = p.getActivePatches();
+    #pragma omp for
+    for(int block = 0; block < activePatches.size(); block += PATCH_MATH_BLOCK) {
+        const int * patches = activePatches.constData() + block;
+        int count = std::min(PATCH_MATH_BLOCK, activePatches.size() - block);
+
+        //Gather the arguments of the block's exp and log10 calls and work them out together
+        double phytoLight[PATCH_MATH_BLOCK];
+        double flowTransfer[PATCH_MATH_BLOCK];
+        double detritusTransfer[PATCH_MATH_BLOCK];
+        for(int n = 0; n < count; n++) {
+            int i = patches[n];
+
+            double phyto = p.phyto[i];
+            Utility::boundValue(phyto, 0.001, 900000.0);
+
+            phytoLight[n] = -1 * phyto * config.kPhyto * p.depth[i];
+            flowTransfer[n] = ((p.flowMagnitude[i] / 40.0 ) + .0001) + 1.0;
+            detritusTransfer[n] = p.flowMagnitude[i] / 40.0 + 0.01;
+        }
+
+        math.exp(phytoLight, phytoLight, count);
+        math.log10(flowTransfer, flowTransfer, count);
+        math.log10(detritusTransfer, detritusTransfer, count);
+
+        for(int n = 0; n < count; n++) {
+            PatchAttenuation attenuation = {phytoLight[n], flowTransfer[n], detritusTransfer[n]};
+            processPatch(p, config, patches[n], forcing, attenuation);
+        }
+    }
+}
+
+void PatchComputation::processPatch(PatchCollection & p, const Configuration & config, int i,
+                                    const HourlyForcing & forcing, const PatchAttenuation & attenuation)
+{
+    /* Every step below is the same arithmetic, in the same order, as the sweeps of
+     * processPatchesReference so the results are identical.  Only the stocks and the
+     * values that carry over to the next hour are stored.
+     */
+    double macro = p.macro[i];
+    double phyto = p.phyto[i];
+    double herbivore = p.herbivore[i];
+    double waterdecomp = p.waterdecomp[i];
+    double seddecomp = p.seddecomp[i];
+    double sedconsumer = p.sedconsumer[i];
+    double consumer = p.consumer[i];
+    double DOC = p.DOC[i];
+    double POC = p.POC[i];
+    double detritus = p.detritus[i];
+    double depth = p.depth[i];
+    double flowMagnitude = p.flowMagnitude[i];
+    double peri = p.peri[i];
+    double scouring_macro = p.scouring_macro[i];
+    double detritus_POC_transfer = p.detritus_POC_transfer[i];
+    double POC_detritus_transfer = p.POC_detritus_transfer[i];
+    double macro_death = p.macro_death[i];
+
+    int currPAR = forcing.currPAR;
+    double turbidity = forcing.turbidity;
+
+    // macro
+    double macroQ10 = forcing.macroQ10;
+    double K;
+    if(flowMagnitude < config.macroVelocityMax) {
+        K = PATCH_AREA
+                * (config.macroMassMax
+                   - (config.macroMassMax  / config.macroVelocityMax)
+                   * flowMagnitude);
+    } else {
+        K = 0.01;
+    }
+    double macro_light = currPAR * p.lightAttenuation[i];
+
+    double gross_photo_macro = config.macroGross * macro
+            * ( macro_light / ( macro_light + 10.0)) * macroQ10
+            * ( K - macro) / K;
+    double respiration_macro = (config.macroRespiration / HOURS_PER_DAY)
+            * macro * macroQ10;
+    double senescence_macro = (config.macroSenescence / HOURS_PER_DAY)
+            * (macro / HOURS_PER_DAY);
+    double growth_macro = (gross_photo_macro - respiration_macro
+            - senescence_macro - scouring_macro) * forcing.currGrowthRate;
+
+    macro += growth_macro;
+    Utility::boundLower(macro, 0.001);
+
+    // phyto
+    Utility::boundValue(phyto, 0.001, 900000.0);
+
+    double phytoQ10 = forcing.phytoQ10;
+    double km = 10;
+
+    double respiration_phyto = (config.phytoRespiration / HOURS_PER_DAY) * phyto * phytoQ10;
+
+    double pre_ln = 0.01 + currPAR
+            * attenuation.phytoLight;
+    double be = km + currPAR
+            * attenuation.phytoLight;
+
+    double gross_photo_phyto = fabs(pre_ln / be) * (1.0 / depth)
+            * (phyto / turbidity) * phytoQ10;
+    double excretion_phyto = (config.phytoExcretion / HOURS_PER_DAY) * phyto;
+    double senescence_phyto = (config.phytoSenescence / HOURS_PER_DAY) * phyto;
+    double growth_phyto = gross_photo_phyto - excretion_phyto -
+            respiration_phyto - senescence_phyto;
+
+    // herbivore
+    double herbivore_phyto_prey_limitation = phyto
+            / (config.herbivoreAiPhyto - config.herbivoreGiPhyto);
+    Utility::boundPercentage(herbivore_phyto_prey_limitation);
+
+    double herbivore_peri_prey_limitation = peri
+            / (config.herbivoreAiPeri - config.herbivoreGiPeri);
+    Utility::boundPercentage(herbivore_peri_prey_limitation);
+
+    double herbivore_waterdecomp_prey_limitation = waterdecomp
+            / (config.herbivoreAiWaterdecomp - config.herbivoreGiWaterdecomp);
+    Utility::boundPercentage(herbivore_waterdecomp_prey_limitation);
+
+    double herbivore_space_limitation = 1.0
+            - ((herbivore - config.herbivoreAj)
+                / (config.herbivoreGj - config.herbivoreAj));
+    Utility::boundPercentage(herbivore_space_limitation);
+
+    double herbivore_pred_phyto = config.herbivorePrefPhyto
+            * (config.herbivoreMax / HOURS_PER_DAY) * herbivore
+            * herbivore_space_limitation * herbivore_phyto_prey_limitation;
+    double herbivore_ingest_phyto = herbivore_pred_phyto * (1.0 - config.herbivoreEgestion);
+
+    double herbivore_pred_peri = config.herbivorePrefPeri
+            * (config.herbivoreMax / HOURS_PER_DAY) * herbivore
+            * herbivore_space_limitation * herbivore_peri_prey_limitation;
+    double herbivore_ingest_peri = herbivore_pred_peri * (1.0 - config.herbivoreEgestion);
+
+    double herbivore_pred_waterdecomp = config.herbivorePrefWaterdecomp
+            * (config.herbivoreMax / HOURS_PER_DAY) * herbivore
+            * herbivore_space_limitation * herbivore_waterdecomp_prey_limitation;
+    double herbivore_ingest_waterdecomp = herbivore_pred_waterdecomp * (1.0 - config.herbivoreEgestion);
+
+    double herbivore_respiration = (config.herbivoreRespiration / HOURS_PER_DAY) * herbivore;
+    double herbivore_excretion = (config.herbivoreExcretion / HOURS_PER_DAY) * herbivore;
+    double herbivore_senescence = (config.herbivoreSenescence / HOURS_PER_DAY) * herbivore;
+
+    // waterDecomp
+    double waterdecomp_doc_prey_limitation = DOC
+            / (config.waterdecompAiDoc - config.waterdecompGiDoc);
+    Utility::boundPercentage(waterdecomp_doc_prey_limitation);
+
+    double waterdecomp_poc_prey_limitation = POC
+            / (config.waterdecompAiPoc - config.waterdecompGiPoc);
+    Utility::boundPercentage(waterdecomp_poc_prey_limitation);
+
+    double waterdecomp_space_limitation = 1.0
+            - ((waterdecomp - config.waterdecompAj)
+                / (config.waterdecompGj - config.waterdecompAj));
+    Utility::boundPercentage(waterdecomp_space_limitation);
+
+    double waterdecomp_pred_doc = config.waterdecompPrefDoc
+            * (config.waterdecompMax / HOURS_PER_DAY) * waterdecomp
+            * waterdecomp_space_limitation * waterdecomp_doc_prey_limitation;
+    double waterdecomp_ingest_doc = waterdecomp_pred_doc;
+
+    double waterdecomp_pred_poc = config.waterdecompPrefPoc
+            * (config.waterdecompMax / HOURS_PER_DAY) * waterdecomp
+            * waterdecomp_space_limitation * waterdecomp_poc_prey_limitation;
+    double waterdecomp_ingest_poc = waterdecomp_pred_poc;
+
+    double waterdecomp_respiration = (config.waterdecompRespiration / HOURS_PER_DAY) * waterdecomp;
+    double waterdecomp_excretion = (config.waterdecompExcretion / HOURS_PER_DAY) * waterdecomp;
+    double waterdecomp_senescence = (config.waterdecompSenescence / HOURS_PER_DAY) * waterdecomp;
+
+    // sedDecomp
+    double seddecomp_detritus_prey_limitation = detritus
+            / (config.seddecompAiDetritus - config.seddecompGiDetritus);
+    Utility::boundPercentage(seddecomp_detritus_prey_limitation);
+
+    double seddecompAj = detritus / 20.0;
+    double seddecompGj = detritus / 5.0;
+
+    double seddecomp_space_limitation;
+    if( (seddecompGj - seddecompAj) != 0.0 ) {
+        seddecomp_space_limitation = 1.0
+                - ((seddecomp - seddecompAj)
+                   / (seddecompGj - seddecompAj));
+        Utility::boundPercentage(seddecomp_space_limitation);
+    } else {
+        seddecomp_space_limitation = 0.0;
+    }
+
+    double seddecomp_pred_detritus = config.seddecompPrefDetritus
+            * (config.seddecompMax / HOURS_PER_DAY) * seddecomp
+            * seddecomp_detritus_prey_limitation * seddecomp_space_limitation;
+    double seddecomp_ingest_detritus = seddecomp_pred_detritus;
+
+    double seddecomp_respiration = (config.seddecompRespiration / HOURS_PER_DAY) * seddecomp;
+    double seddecomp_excretion = (config.seddecompExcretion / HOURS_PER_DAY) * seddecomp;
+    double seddecomp_senescence = (config.seddecompSenescence / HOURS_PER_DAY) * seddecomp;
+
+    // sedConsumer
+    double sedconsumer_seddecomp_prey_limitation = seddecomp
+            / (config.sedconsumerAiSeddecomp - config.sedconsumerGiSeddecomp);
+    Utility::boundPercentage(sedconsumer_seddecomp_prey_limitation);
+
+    double sedconsumer_peri_prey_limitation = peri
+            / (config.sedconsumerAiPeri - config.sedconsumerGiPeri);
+    Utility::boundPercentage(sedconsumer_peri_prey_limitation);
+
+    double sedconsumer_detritus_prey_limitation = detritus
+            / (config.sedconsumerAiDetritus - config.sedconsumerGiDetritus);
+    Utility::boundPercentage(sedconsumer_detritus_prey_limitation);
+
+    double sedconsumer_space_limitation = 1.0
+            - ((sedconsumer - config.sedconsumerAj)
+               / (config.sedconsumerGj - config.sedconsumerAj));
+    Utility::boundPercentage(sedconsumer_space_limitation);
+
+    double sedconsumer_pred_peri = config.sedconsumerPrefPeri
+            * (config.sedconsumerMax / HOURS_PER_DAY) * sedconsumer
+            * sedconsumer_space_limitation * sedconsumer_peri_prey_limitation;
+    double sedconsumer_ingest_peri = sedconsumer_pred_peri * (1.0 - config.sedconsumerEgestionSeddecomp);
+
+    double sedconsumer_pred_seddecomp = config.sedconsumerPrefSeddecomp
+            * (config.sedconsumerMax / HOURS_PER_DAY) * sedconsumer
+            * sedconsumer_space_limitation * sedconsumer_seddecomp_prey_limitation;
+    double sedconsumer_ingest_seddecomp = sedconsumer_pred_seddecomp * (1.0 - config.sedconsumerEgestionSeddecomp);
+
+    double sedconsumer_respiration = (config.sedconsumerRespiration / HOURS_PER_DAY) * sedconsumer;
+    double sedconsumer_excretion = (config.sedconsumerExcretion / HOURS_PER_DAY) * sedconsumer;
+    double sedconsumer_senescence = (config.sedconsumerSenescence / HOURS_PER_DAY) * sedconsumer;
+
+    // consumer
+    double consumer_sedconsumer_prey_limitation = sedconsumer
+            / (config.consumerAiSedconsumer - config.consumerGiSedconsumer);
+    Utility::boundPercentage(consumer_sedconsumer_prey_limitation);
+
+    double consumer_herbivore_prey_limitation = herbivore
+            / (config.consumerAiHerbivore - config.consumerGiHerbivore);
+    Utility::boundPercentage(consumer_herbivore_prey_limitation);
+
+    double consumer_space_limitation = 1.0
+            - ((consumer - config.consumerAj)
+               / (config.consumerGj - config.consumerAj));
+    Utility::boundPercentage(consumer_space_limitation);
+
+    double consumer_pred_herbivore = config.consumerPrefHerbivore
+            * (config.consumerMax / HOURS_PER_DAY) * consumer
+            * consumer_space_limitation * consumer_herbivore_prey_limitation;
+    double consumer_ingest_herbivore = consumer_pred_herbivore * (1.0- config.consumerEgestion);
+
+    double consumer_pred_sedconsumer = config.consumerPrefSedconsumer
+            * (config.consumerMax / HOURS_PER_DAY) * consumer
+            * consumer_space_limitation * consumer_sedconsumer_prey_limitation;
+    double consumer_ingest_sedconsumer = consumer_pred_sedconsumer * (1.0 - config.consumerEgestion);
+
+    double consumer_respiration = (config.consumerRespiration / HOURS_PER_DAY) * consumer;
+    double consumer_excretion = (config.consumerExcretion / HOURS_PER_DAY) * consumer;
+    double consumer_senescence = (config.consumerSenescence / HOURS_PER_DAY) * consumer;
+
+    // DOC
+    double macro_exudation = config.macroExcretion * macro;
+    double micro_death = senescence_macro * .01 + senescence_phyto * .01;
+    double excretion = herbivore_excretion + waterdecomp_excretion +
+            seddecomp_excretion + sedconsumer_excretion +
+            consumer_excretion + excretion_phyto + p.peri_excretion[i];
+    double flocculation = .01 * DOC;
+    double DOC_growth = macro_exudation + micro_death + excretion;
+
+    // POC
+    if(flowMagnitude > 0.0)
+    {
+        detritus_POC_transfer = detritus * (.25 * attenuation.flowTransfer);
+    }
+    Utility::boundUpper(detritus_POC_transfer, 1.0);
+
+    double POC_growth = flocculation + detritus_POC_transfer;
+
+    // detritus
+    if(flowMagnitude > 0.0) {
+        POC_detritus_transfer = POC * (1.0 - (0.25 * attenuation.flowTransfer));
+    }
+    Utility::boundLower(POC_detritus_transfer, 0.0);
+
+    if(flowMagnitude == 0.0) {
+        POC_detritus_transfer = POC * 0.9;
+    }
+
+    if(gross_photo_macro < 0.0) {
+        macro_death = 0.0 - gross_photo_macro;
+    }
+
+    double large_death = senescence_macro * 0.9 + scouring_macro * 0.9 +
+            senescence_phyto * 0.9 + seddecomp_senescence +
+            waterdecomp_senescence * 0.3 + herbivore_senescence +
+            sedconsumer_senescence + consumer_senescence + 0.07 * p.peri_senescence[i];
+
+    double egestion = config.herbivoreEgestion + p.sedconsumer_egestion[i] + config.consumerEgestion;
+
+    double detritus_growth = large_death + POC_detritus_transfer +
+            egestion + macro_death;
+
+    // pred*
+    phyto = phyto + growth_phyto - herbivore_pred_phyto;
+    Utility::boundLower(phyto, 0.001);
+
+    herbivore = herbivore + herbivore_ingest_phyto
+            + herbivore_ingest_peri + herbivore_ingest_waterdecomp
+            - (herbivore_respiration + herbivore_excretion + herbivore_senescence)
+            - consumer_pred_herbivore;
+    Utility::boundLower(herbivore, 0.001);
+
+    seddecomp = seddecomp + seddecomp_ingest_detritus
+            - (seddecomp_respiration + seddecomp_excretion + seddecomp_senescence)
+            - sedconsumer_pred_seddecomp;
+    Utility::boundLower(seddecomp, 0.001);
+
+    waterdecomp = waterdecomp + waterdecomp_ingest_doc + waterdecomp_ingest_poc
+            - (waterdecomp_respiration + waterdecomp_excretion
+            + waterdecomp_senescence) - herbivore_pred_waterdecomp;
+    Utility::boundLower(waterdecomp, 0.001);
+
+    sedconsumer = sedconsumer + sedconsumer_ingest_peri + sedconsumer_ingest_seddecomp
+            - (sedconsumer_respiration + sedconsumer_excretion + sedconsumer_senescence)
+            - consumer_pred_sedconsumer;
+    Utility::boundLower(sedconsumer, 0.001);
+
+    detritus_POC_transfer = detritus
+            * (0.25 * attenuation.detritusTransfer + 0.5);
+    detritus = detritus + detritus_growth - seddecomp_pred_detritus
+            - detritus_POC_transfer;
+    Utility::boundLower(detritus, 0.001);
+
+    DOC = DOC + DOC_growth - waterdecomp_pred_doc - flocculation;
+    Utility::boundLower(DOC, 0.001);
+
+    POC = POC + POC_growth - waterdecomp_pred_poc - POC_detritus_transfer;
+    Utility::boundLower(POC, 0.001);
+
+    consumer = consumer + consumer_ingest_herbivore + consumer_ingest_sedconsumer
+            - (consumer_respiration + consumer_excretion + consumer_senescence);
+    Utility::boundLower(consumer, 0.001);
+
+    p.macro[i] = macro;
+    p.phyto[i] = phyto;
+    p.herbivore[i] = herbivore;
+    p.waterdecomp[i] = waterdecomp;
+    p.seddecomp[i] = seddecomp;
+    p.sedconsumer[i] = sedconsumer;
+    p.consumer[i] = consumer;
+    p.DOC[i] = DOC;
+    p.POC[i] = POC;
+    p.detritus[i] = detritus;
+    p.detritus_POC_transfer[i] = detritus_POC_transfer;
+    p.POC_detritus_transfer[i] = POC_detritus_transfer;
+    p.macro_death[i] = macro_death;
+}
@@ -1,20 +1,92 @@
 #ifndef PATCHCOMPUTATION_H
 #define PATCHCOMPUTATION_H
+#include <algorithm>
 #include <cmath>
 #include <omp.h>
 #include "constants.h"
 #include "patchcollection.h"
+#include "patchmath.h"
 #include "configuration.h"
 #include "utility.h"
 
+//Patches whose exp and log10 arguments processPatchesFused hands to PatchMath at once
+#define PATCH_MATH_BLOCK 256
+
 /**
  * @brief A collection of all the processing functions.
  */
 namespace PatchComputation {
 
-    void updatePatches(PatchCollection & p, const Configuration & config, int currPAR);
-    void macro(PatchCollection & p, const Configuration & config, int currPAR, int currWaterTemp, double currGrowthRate);
-    void phyto(PatchCollection & p, const Configuration & config, int currPAR, int currWaterTemp);
+    /**
+     * @brief The hour's forcing and the terms derived from it that are the same for every
+     *        patch, worked out once per hour by getHourlyForcing
+     */
+    struct HourlyForcing {
+        int currPAR;
+        int currWaterTemp;
+        double currGrowthRate;
+        double turbidity;
+        double macroQ10;
+        double phytoQ10;
+    };
+
+    HourlyForcing getHourlyForcing(const Configuration & config, int currPAR, int currWaterTemp,
+                                   double currGrowthRate);
+
+    /**
+     * @brief Returns the turbidity of the water, which only depends on config.tss
+     */
+    double getTurbidity(const Configuration & config);
+
+    /**
+     * @brief Signature shared by the hourly biology updates of every patch.  They are
+     *        called by every thread of an omp parallel region.  The light reaching the
+     *        bottom of each patch is read from PatchCollection::lightAttenuation.
+     */
+    typedef void (*ProcessFunction)(PatchCollection & p, const Configuration & config,
+                                    const HourlyForcing & forcing);
+
+    /**
+     * @brief Reference update, one sweep over the patches per process below followed by a
+     *        sweep of the pred* updates.  Also fills in the flux arrays, so the patches
+     *        must have them, see PatchCollection::hasFluxes().
+     */
+    void processPatchesReference(PatchCollection & p, const Configuration & config,
+                                 const HourlyForcing & forcing);
+
+    /**
+     * @brief Same results as processPatchesReference in a single sweep, see processPatch.
+     *        The exp and log10 of each block of patches are worked out together by the
+     *        PatchMath array kernels.
+     */
+    void processPatchesFused(PatchCollection & p, const Configuration & config,
+                             const HourlyForcing & forcing);
+
+    /**
+     * @brief The exp and log10 results of one patch's hourly update.  The light reaching
+     *        the bottom only depends on the hydromap and is cached with it instead.
+     */
+    struct PatchAttenuation {
+        //exp(-phyto * kPhyto * depth), the fraction of light the phytoplankton let through
+        double phytoLight;
+        //log10(flowMagnitude / 40 + 1.0001), scales the exchange between POC and detritus
+        double flowTransfer;
+        //log10(flowMagnitude / 40 + 0.01), scales the detritus carried into the water
+        double detritusTransfer;
+    };
+
+    /**
+     * @brief Does the whole hourly update of one patch with its intermediate values kept
+     *        in locals.  Only the stocks and the values carried over to the next hour are
+     *        written back, the other per patch arrays are left as they were.
+     * @param attenuation The patch's exp and log10 results, computed with PatchMath
+     */
+    void processPatch(PatchCollection & p, const Configuration & config, int i,
+                      const HourlyForcing & forcing, const PatchAttenuation & attenuation);
+
+    void updatePatches(PatchCollection & p, const HourlyForcing & forcing);
+    void macro(PatchCollection & p, const Configuration & config, const HourlyForcing & forcing);
+    void phyto(PatchCollection & p, const Configuration & config, const HourlyForcing & forcing);
     void herbivore(PatchCollection & p, const Configuration & config);
     void waterDecomp(PatchCollection & p, const Configuration & config);
     void sedDecomp(PatchCollection & p, const Configuration & config);
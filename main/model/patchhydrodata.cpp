@@ -0,0 +1,83 @@
+#include "patchhydrodata.h"
+#include "patchcollection.h"
+
+PatchHydroData::PatchHydroData() {
+    turbidity = 0.0;
+}
+
+PatchHydroData::PatchHydroData(const HydroFile & hydroFile, const HydroGeometry & geometry) {
+    turbidity = 0.0;
+
+    int size = geometry.getSize();
+    depth.fill(0.0, size);
+    flowX.fill(0.0, size);
+    flowY.fill(0.0, size);
+    flowMagnitude.fill(0.0, size);
+    hasWater.fill(false, size);
+    isInput.fill(false, size);
+    isOutput.fill(false, size);
+
+    const int * patchX = geometry.getPatchX();
+    const int * patchY = geometry.getPatchY();
+    const double * depths = hydroFile.getDepths();
+    const float * flowVectors = hydroFile.getFlowVectors();
+    const double * fileVelocities = hydroFile.getFileVelocities();
+    const unsigned char * ioFlags = hydroFile.getIOFlags();
+
+    for(int i = 0; i < size; i++) {
+        int cell = hydroFile.getCellIndex(patchX[i], patchY[i]);
+        if(cell < 0) {
+            continue;
+        }
+
+        depth[i] = depths[cell];
+        flowX[i] = flowVectors[2 * cell];
+        flowY[i] = flowVectors[2 * cell + 1];
+        //TODO Replace this line with flowVector.length() once we know if it is correct to do so.
+        flowMagnitude[i] = fileVelocities[cell];
+        hasWater[i] = true;
+        isInput[i] = (ioFlags[cell] & HYDRO_FILE_INPUT) != 0;
+        isOutput[i] = (ioFlags[cell] & HYDRO_FILE_OUTPUT) != 0;
+
+        //Only water cells are inputs, so these are also every patch with water or an input
+        activePatches.append(i);
+        if(isInput[i]) {
+            inputPatches.append(i);
+        }
+    }
+}
+
+void PatchHydroData::apply(PatchCollection & patches) const {
+    int size = depth.size();
+    memcpy(patches.depth, depth.constData(), sizeof(double) * size);
+    memcpy(patches.flowX, flowX.constData(), sizeof(double) * size);
+    memcpy(patches.flowY, flowY.constData(), sizeof(double) * size);
+    memcpy(patches.flowMagnitude, flowMagnitude.constData(), sizeof(double) * size);
+    for(int i = 0; i < size; i++) {
+        patches.hasWater[i] = hasWater[i];
+        patches.isInput[i] = isInput[i];
+        patches.isOutput[i] = isOutput[i];
+    }
+    patches.setActivePatches(activePatches, inputPatches);
+
+    if(lightAttenuation.size() == size) {
+        applyLightAttenuation(patches);
+    }
+}
+
+void PatchHydroData::setTurbidity(double newTurbidity) {
+    if(lightAttenuation.size() == depth.size() && turbidity == newTurbidity) {
+        return;
+    }
+
+    turbidity = newTurbidity;
+    lightAttenuation.resize(depth.size());
+    for(int i = 0; i < depth.size(); i++) {
+        lightAttenuation[i] = (-1 * depth[i]) * turbidity;
+    }
+    PatchMath::selected().exp(lightAttenuation.constData(), lightAttenuation.data(), lightAttenuation.size());
+}
+
+void PatchHydroData::applyLightAttenuation(PatchCollection & patches) const {
+    memcpy(patches.lightAttenuation, lightAttenuation.constData(), sizeof(double) * lightAttenuation.size());
+}
@@ -0,0 +1,66 @@
+#ifndef PATCHHYDRODATA_H
+#define PATCHHYDRODATA_H
+
+#include <cstring>
+#include <QVector>
+
+#include "hydrofile.h"
+#include "hydrogeometry.h"
+#include "patchmath.h"
+
+class PatchCollection;
+
+/**
+ * @brief The PatchHydroData class holds the hydro data of one hydromap as dense arrays
+ *        over the patches of a HydroGeometry, laid out like the PatchCollection arrays.
+ *        Switching the river to the hydromap is then a handful of array copies instead
+ *        of a lookup per patch.
+ */
+class PatchHydroData {
+    public:
+        /**
+         * @brief Default constructor, holds no patches
+         */
+        PatchHydroData();
+
+        /**
+         * @brief Looks up every patch in the hydromap.  Patches without a water cell are land.
+         * @param hydroFile The hydromap
+         * @param geometry The patches of every hydromap of the simulation
+         */
+        PatchHydroData(const HydroFile & hydroFile, const HydroGeometry & geometry);
+
+        /**
+         * @brief Copies the hydro data into the patches' depth, flow and IO arrays, and the
+         *        light attenuation once setTurbidity has been called.  The patches must be
+         *        numbered by the same geometry.
+         */
+        void apply(PatchCollection & patches) const;
+
+        /**
+         * @brief Computes the fraction of light reaching the bottom of each patch for a
+         *        turbidity, unless it is already cached for that turbidity
+         */
+        void setTurbidity(double newTurbidity);
+
+        /**
+         * @brief Copies the cached light attenuation into the patches
+         */
+        void applyLightAttenuation(PatchCollection & patches) const;
+
+        QVector<double> depth;
+        QVector<double> flowX;
+        QVector<double> flowY;
+        QVector<double> flowMagnitude;
+        QVector<bool> hasWater;
+        QVector<bool> isInput;
+        QVector<bool> isOutput;
+
+        QVector<int> activePatches; ///< indices of the patches with water
+        QVector<int> inputPatches;  ///< indices of the patches that are river inputs
+
+        QVector<double> lightAttenuation;  ///< exp(-depth * turbidity), empty until setTurbidity
+        double turbidity;                  ///< the turbidity lightAttenuation is for
+};
+
+#endif // PATCHHYDRODATA_H
@@ -0,0 +1,507 @@
+#include "patchmath.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+//The vectorized kernels are only built where we can ask the compiler for AVX2 and AVX-512
+//on a single function and check for them at runtime.  Everything else uses the scalar kernels.
+#if !defined(PATCH_MATH_LIBM) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PATCHMATH_HAS_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/* exp(x) = 2^k * exp(r) with k = round(x / ln 2) and |r| <= ln 2 / 2.  ln 2 is split in two
+ * so k * LN2_HI is exact, exp(r) is its Taylor series to r^13 and 2^k is applied as two
+ * powers of two so k can reach 1024 without building an infinite scale.
+ */
+const double EXP_MIN = -708.39;
+const double EXP_MAX = 709.782712893384;
+const double LOG2E = 1.44269504088896338700e+00;
+const double LN2_HI = 6.93147180369123816490e-01;
+const double LN2_LO = 1.90821492927058770002e-10;
+const int EXP_TERMS = 14;
+const double EXP_COEFFICIENTS[EXP_TERMS] = {
+    1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0,
+    1.0 / 362880.0, 1.0 / 40320.0, 1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0,
+    1.0 / 6.0, 1.0 / 2.0, 1.0, 1.0
+};
+
+/* log10(x) = e * log10(2) + log(m) / ln 10 with x = 2^e * m and sqrt(1/2) < m <= sqrt(2).
+ * With f = m - 1, which is exact, and s = f / (2 + f)
+ *   log(m) = f - hfsq + s * (hfsq + R),  hfsq = f^2 / 2,  R = 2 * (s^2/3 + s^4/5 + ... + s^22/23)
+ * so the rounding of s only reaches the small correction.  f - hfsq is split into hi, its
+ * top 21 bits, and lo so hi * INV_LN10_HI is exact, and log10(2) and 1 / ln 10 are split in
+ * two so the large products carry no rounding error.  The parts are summed from the smallest.
+ */
+const double LOG_MIN = 2.2250738585072014e-308;
+const double LOG_MAX = 1.7976931348623157e+308;
+const double SQRT2 = 1.41421356237309504880;
+const double LOG10_2_HI = 3.01029995663611771306e-01;
+const double LOG10_2_LO = 3.69423907715893078616e-13;
+const double INV_LN10_HI = 4.34294481878168880939e-01;
+const double INV_LN10_LO = 2.50829467116452752298e-11;
+const uint64_t LOG_HI_MASK = 0xFFFFFFFF00000000ULL;
+const int LOG_TERMS = 11;
+const double LOG_COEFFICIENTS[LOG_TERMS] = {
+    1.0 / 23.0, 1.0 / 21.0, 1.0 / 19.0, 1.0 / 17.0, 1.0 / 15.0, 1.0 / 13.0,
+    1.0 / 11.0, 1.0 / 9.0, 1.0 / 7.0, 1.0 / 5.0, 1.0 / 3.0
+};
+
+const uint64_t EXPONENT_MASK = 0x7FF0000000000000ULL;
+const uint64_t MANTISSA_MASK = 0x000FFFFFFFFFFFFFULL;
+const uint64_t ONE_BITS = 0x3FF0000000000000ULL;
+
+//2^52, adding a small integer valued double to it leaves the integer in the low bits
+const double INTEGER_MAGIC = 4503599627370496.0;
+
+inline double fromBits(uint64_t bits) {
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+inline uint64_t toBits(double x) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+//2^k for an integer valued k from -1022 to 1023
+inline double powerOfTwo(double k) {
+    return fromBits((uint64_t)(int64_t)(k + 1023.0) << 52);
+}
+
+#ifdef PATCHMATH_HAS_SIMD
+
+/* The vector kernels below repeat the scalar steps one for one.  They are built without
+ * fma and with contraction off so no multiply and add gets fused into a differently
+ * rounded instruction.
+ */
+
+__attribute__((target("avx2"), optimize("fp-contract=off")))
+inline __m256d powerOfTwoAVX2(__m256d k) {
+    __m256i bits = _mm256_castpd_si256(_mm256_add_pd(_mm256_add_pd(k, _mm256_set1_pd(1023.0)),
+                                                     _mm256_set1_pd(INTEGER_MAGIC)));
+    return _mm256_castsi256_pd(_mm256_slli_epi64(bits, 52));
+}
+
+__attribute__((target("avx2"), optimize("fp-contract=off")))
+inline __m256d expAVX2Vector(__m256d x) {
+    __m256d k = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(LOG2E)),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_sub_pd(_mm256_sub_pd(x, _mm256_mul_pd(k, _mm256_set1_pd(LN2_HI))),
+                              _mm256_mul_pd(k, _mm256_set1_pd(LN2_LO)));
+
+    __m256d sum = _mm256_set1_pd(EXP_COEFFICIENTS[0]);
+    for(int term = 1; term < EXP_TERMS; term++) {
+        sum = _mm256_add_pd(_mm256_mul_pd(sum, r), _mm256_set1_pd(EXP_COEFFICIENTS[term]));
+    }
+
+    __m256d k1 = _mm256_floor_pd(_mm256_mul_pd(k, _mm256_set1_pd(0.5)));
+    __m256d k2 = _mm256_sub_pd(k, k1);
+    return _mm256_mul_pd(_mm256_mul_pd(sum, powerOfTwoAVX2(k1)), powerOfTwoAVX2(k2));
+}
+
+__attribute__((target("avx2"), optimize("fp-contract=off")))
+inline __m256d log10AVX2Vector(__m256d x) {
+    __m256i bits = _mm256_castpd_si256(x);
+    __m256d exponent = _mm256_sub_pd(
+                _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52),
+                                                    _mm256_castpd_si256(_mm256_set1_pd(INTEGER_MAGIC)))),
+                _mm256_set1_pd(INTEGER_MAGIC));
+    __m256d e = _mm256_sub_pd(exponent, _mm256_set1_pd(1023.0));
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(
+                _mm256_and_si256(bits, _mm256_set1_epi64x(MANTISSA_MASK)),
+                _mm256_set1_epi64x(ONE_BITS)));
+
+    __m256d large = _mm256_cmp_pd(m, _mm256_set1_pd(SQRT2), _CMP_GT_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), large);
+    e = _mm256_blendv_pd(e, _mm256_add_pd(e, _mm256_set1_pd(1.0)), large);
+
+    __m256d f = _mm256_sub_pd(m, _mm256_set1_pd(1.0));
+    __m256d hfsq = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), f), f);
+    __m256d s = _mm256_div_pd(f, _mm256_add_pd(_mm256_set1_pd(2.0), f));
+    __m256d z = _mm256_mul_pd(s, s);
+    __m256d sum = _mm256_set1_pd(LOG_COEFFICIENTS[0]);
+    for(int term = 1; term < LOG_TERMS; term++) {
+        sum = _mm256_add_pd(_mm256_mul_pd(sum, z), _mm256_set1_pd(LOG_COEFFICIENTS[term]));
+    }
+    __m256d r = _mm256_mul_pd(s, _mm256_add_pd(hfsq, _mm256_mul_pd(_mm256_add_pd(z, z), sum)));
+
+    __m256d hi = _mm256_castsi256_pd(_mm256_and_si256(_mm256_castpd_si256(_mm256_sub_pd(f, hfsq)),
+                                                     _mm256_set1_epi64x(LOG_HI_MASK)));
+    __m256d lo = _mm256_add_pd(_mm256_sub_pd(_mm256_sub_pd(f, hi), hfsq), r);
+    __m256d valueHi = _mm256_mul_pd(hi, _mm256_set1_pd(INV_LN10_HI));
+    __m256d eHi = _mm256_mul_pd(e, _mm256_set1_pd(LOG10_2_HI));
+    __m256d valueLo = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(e, _mm256_set1_pd(LOG10_2_LO)),
+                                                  _mm256_mul_pd(_mm256_add_pd(lo, hi), _mm256_set1_pd(INV_LN10_LO))),
+                                    _mm256_mul_pd(lo, _mm256_set1_pd(INV_LN10_HI)));
+    __m256d w = _mm256_add_pd(eHi, valueHi);
+    valueLo = _mm256_add_pd(valueLo, _mm256_add_pd(_mm256_sub_pd(eHi, w), valueHi));
+    return _mm256_add_pd(valueLo, w);
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+inline __m512d powerOfTwoAVX512(__m512d k) {
+    __m512i bits = _mm512_castpd_si512(_mm512_add_pd(_mm512_add_pd(k, _mm512_set1_pd(1023.0)),
+                                                     _mm512_set1_pd(INTEGER_MAGIC)));
+    return _mm512_castsi512_pd(_mm512_slli_epi64(bits, 52));
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+inline __m512d expAVX512Vector(__m512d x) {
+    __m512d k = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(LOG2E)),
+                                     _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_sub_pd(_mm512_sub_pd(x, _mm512_mul_pd(k, _mm512_set1_pd(LN2_HI))),
+                              _mm512_mul_pd(k, _mm512_set1_pd(LN2_LO)));
+
+    __m512d sum = _mm512_set1_pd(EXP_COEFFICIENTS[0]);
+    for(int term = 1; term < EXP_TERMS; term++) {
+        sum = _mm512_add_pd(_mm512_mul_pd(sum, r), _mm512_set1_pd(EXP_COEFFICIENTS[term]));
+    }
+
+    __m512d k1 = _mm512_roundscale_pd(_mm512_mul_pd(k, _mm512_set1_pd(0.5)),
+                                      _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    __m512d k2 = _mm512_sub_pd(k, k1);
+    return _mm512_mul_pd(_mm512_mul_pd(sum, powerOfTwoAVX512(k1)), powerOfTwoAVX512(k2));
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+inline __m512d log10AVX512Vector(__m512d x) {
+    __m512i bits = _mm512_castpd_si512(x);
+    __m512d exponent = _mm512_sub_pd(
+                _mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(bits, 52),
+                                                    _mm512_castpd_si512(_mm512_set1_pd(INTEGER_MAGIC)))),
+                _mm512_set1_pd(INTEGER_MAGIC));
+    __m512d e = _mm512_sub_pd(exponent, _mm512_set1_pd(1023.0));
+    __m512d m = _mm512_castsi512_pd(_mm512_or_si512(
+                _mm512_and_si512(bits, _mm512_set1_epi64(MANTISSA_MASK)),
+                _mm512_set1_epi64(ONE_BITS)));
+
+    __mmask8 large = _mm512_cmp_pd_mask(m, _mm512_set1_pd(SQRT2), _CMP_GT_OQ);
+    m = _mm512_mask_mul_pd(m, large, m, _mm512_set1_pd(0.5));
+    e = _mm512_mask_add_pd(e, large, e, _mm512_set1_pd(1.0));
+
+    __m512d f = _mm512_sub_pd(m, _mm512_set1_pd(1.0));
+    __m512d hfsq = _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(0.5), f), f);
+    __m512d s = _mm512_div_pd(f, _mm512_add_pd(_mm512_set1_pd(2.0), f));
+    __m512d z = _mm512_mul_pd(s, s);
+    __m512d sum = _mm512_set1_pd(LOG_COEFFICIENTS[0]);
+    for(int term = 1; term < LOG_TERMS; term++) {
+        sum = _mm512_add_pd(_mm512_mul_pd(sum, z), _mm512_set1_pd(LOG_COEFFICIENTS[term]));
+    }
+    __m512d r = _mm512_mul_pd(s, _mm512_add_pd(hfsq, _mm512_mul_pd(_mm512_add_pd(z, z), sum)));
+
+    __m512d hi = _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(_mm512_sub_pd(f, hfsq)),
+                                                     _mm512_set1_epi64(LOG_HI_MASK)));
+    __m512d lo = _mm512_add_pd(_mm512_sub_pd(_mm512_sub_pd(f, hi), hfsq), r);
+    __m512d valueHi = _mm512_mul_pd(hi, _mm512_set1_pd(INV_LN10_HI));
+    __m512d eHi = _mm512_mul_pd(e, _mm512_set1_pd(LOG10_2_HI));
+    __m512d valueLo = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(e, _mm512_set1_pd(LOG10_2_LO)),
+                                                  _mm512_mul_pd(_mm512_add_pd(lo, hi), _mm512_set1_pd(INV_LN10_LO))),
+                                    _mm512_mul_pd(lo, _mm512_set1_pd(INV_LN10_HI)));
+    __m512d w = _mm512_add_pd(eHi, valueHi);
+    valueLo = _mm512_add_pd(valueLo, _mm512_add_pd(_mm512_sub_pd(eHi, w), valueHi));
+    return _mm512_add_pd(valueLo, w);
+}
+
+#endif
+
+}
+
+#ifndef PATCH_MATH_LIBM
+
+__attribute__((optimize("fp-contract=off")))
+double PatchMath::exp(double x) {
+    if(!(x >= EXP_MIN && x <= EXP_MAX)) {
+        return std::exp(x);
+    }
+
+    double k = std::nearbyint(x * LOG2E);
+    double r = (x - k * LN2_HI) - k * LN2_LO;
+
+    double sum = EXP_COEFFICIENTS[0];
+    for(int term = 1; term < EXP_TERMS; term++) {
+        sum = sum * r + EXP_COEFFICIENTS[term];
+    }
+
+    double k1 = std::floor(k * 0.5);
+    double k2 = k - k1;
+    return (sum * powerOfTwo(k1)) * powerOfTwo(k2);
+}
+
+__attribute__((optimize("fp-contract=off")))
+double PatchMath::log10(double x) {
+    if(!(x >= LOG_MIN && x <= LOG_MAX)) {
+        return std::log10(x);
+    }
+
+    uint64_t bits = toBits(x);
+    double e = (double)(int)((bits & EXPONENT_MASK) >> 52) - 1023.0;
+    double m = fromBits((bits & MANTISSA_MASK) | ONE_BITS);
+    if(m > SQRT2) {
+        m = m * 0.5;
+        e = e + 1.0;
+    }
+
+    double f = m - 1.0;
+    double hfsq = 0.5 * f * f;
+    double s = f / (2.0 + f);
+    double z = s * s;
+    double sum = LOG_COEFFICIENTS[0];
+    for(int term = 1; term < LOG_TERMS; term++) {
+        sum = sum * z + LOG_COEFFICIENTS[term];
+    }
+    double r = s * (hfsq + (z + z) * sum);
+
+    double hi = fromBits(toBits(f - hfsq) & LOG_HI_MASK);
+    double lo = ((f - hi) - hfsq) + r;
+    double valueHi = hi * INV_LN10_HI;
+    double eHi = e * LOG10_2_HI;
+    double valueLo = (e * LOG10_2_LO + (lo + hi) * INV_LN10_LO) + lo * INV_LN10_HI;
+    double w = eHi + valueHi;
+    valueLo = valueLo + ((eHi - w) + valueHi);
+    return valueLo + w;
+}
+
+#else
+
+double PatchMath::exp(double x) {
+    return std::exp(x);
+}
+
+double PatchMath::log10(double x) {
+    return std::log10(x);
+}
+
+#endif
+
+void PatchMath::expScalar(const double * x, double * y, int n) {
+    for(int i = 0; i < n; i++) {
+        y[i] = exp(x[i]);
+    }
+}
+
+void PatchMath::log10Scalar(const double * x, double * y, int n) {
+    for(int i = 0; i < n; i++) {
+        y[i] = log10(x[i]);
+    }
+}
+
+#ifdef PATCHMATH_HAS_SIMD
+
+/* Lanes outside the range the polynomials cover are computed on a placeholder argument and
+ * then replaced by libm's result, read from x before y is stored so x and y can be the same
+ * array.  The last n % width values are done by the scalar kernel.
+ */
+
+__attribute__((target("avx2"), optimize("fp-contract=off")))
+void PatchMath::expAVX2(const double * x, double * y, int n) {
+    int i = 0;
+    for(; i + 4 <= n; i += 4) {
+        __m256d value = _mm256_loadu_pd(x + i);
+        __m256d inRange = _mm256_and_pd(_mm256_cmp_pd(value, _mm256_set1_pd(EXP_MIN), _CMP_GE_OQ),
+                                        _mm256_cmp_pd(value, _mm256_set1_pd(EXP_MAX), _CMP_LE_OQ));
+        __m256d result = expAVX2Vector(_mm256_and_pd(value, inRange));
+
+        int lanes = _mm256_movemask_pd(inRange);
+        if(lanes != 0xF) {
+            double results[4];
+            _mm256_storeu_pd(results, result);
+            for(int lane = 0; lane < 4; lane++) {
+                if(!(lanes & (1 << lane))) {
+                    results[lane] = std::exp(x[i + lane]);
+                }
+            }
+            result = _mm256_loadu_pd(results);
+        }
+        _mm256_storeu_pd(y + i, result);
+    }
+    expScalar(x + i, y + i, n - i);
+}
+
+__attribute__((target("avx2"), optimize("fp-contract=off")))
+void PatchMath::log10AVX2(const double * x, double * y, int n) {
+    int i = 0;
+    for(; i + 4 <= n; i += 4) {
+        __m256d value = _mm256_loadu_pd(x + i);
+        __m256d inRange = _mm256_and_pd(_mm256_cmp_pd(value, _mm256_set1_pd(LOG_MIN), _CMP_GE_OQ),
+                                        _mm256_cmp_pd(value, _mm256_set1_pd(LOG_MAX), _CMP_LE_OQ));
+        __m256d result = log10AVX2Vector(_mm256_blendv_pd(_mm256_set1_pd(1.0), value, inRange));
+
+        int lanes = _mm256_movemask_pd(inRange);
+        if(lanes != 0xF) {
+            double results[4];
+            _mm256_storeu_pd(results, result);
+            for(int lane = 0; lane < 4; lane++) {
+                if(!(lanes & (1 << lane))) {
+                    results[lane] = std::log10(x[i + lane]);
+                }
+            }
+            result = _mm256_loadu_pd(results);
+        }
+        _mm256_storeu_pd(y + i, result);
+    }
+    log10Scalar(x + i, y + i, n - i);
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+void PatchMath::expAVX512(const double * x, double * y, int n) {
+    int i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m512d value = _mm512_loadu_pd(x + i);
+        __mmask8 inRange = _mm512_cmp_pd_mask(value, _mm512_set1_pd(EXP_MIN), _CMP_GE_OQ)
+                & _mm512_cmp_pd_mask(value, _mm512_set1_pd(EXP_MAX), _CMP_LE_OQ);
+        __m512d result = expAVX512Vector(_mm512_maskz_mov_pd(inRange, value));
+
+        if(inRange != 0xFF) {
+            double results[8];
+            _mm512_storeu_pd(results, result);
+            for(int lane = 0; lane < 8; lane++) {
+                if(!(inRange & (1 << lane))) {
+                    results[lane] = std::exp(x[i + lane]);
+                }
+            }
+            result = _mm512_loadu_pd(results);
+        }
+        _mm512_storeu_pd(y + i, result);
+    }
+    expScalar(x + i, y + i, n - i);
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+void PatchMath::log10AVX512(const double * x, double * y, int n) {
+    int i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m512d value = _mm512_loadu_pd(x + i);
+        __mmask8 inRange = _mm512_cmp_pd_mask(value, _mm512_set1_pd(LOG_MIN), _CMP_GE_OQ)
+                & _mm512_cmp_pd_mask(value, _mm512_set1_pd(LOG_MAX), _CMP_LE_OQ);
+        __m512d result = log10AVX512Vector(_mm512_mask_mov_pd(_mm512_set1_pd(1.0), inRange, value));
+
+        if(inRange != 0xFF) {
+            double results[8];
+            _mm512_storeu_pd(results, result);
+            for(int lane = 0; lane < 8; lane++) {
+                if(!(inRange & (1 << lane))) {
+                    results[lane] = std::log10(x[i + lane]);
+                }
+            }
+            result = _mm512_loadu_pd(results);
+        }
+        _mm512_storeu_pd(y + i, result);
+    }
+    log10Scalar(x + i, y + i, n - i);
+}
+
+#else
+
+void PatchMath::expAVX2(const double * x, double * y, int n) {
+    expScalar(x, y, n);
+}
+
+void PatchMath::log10AVX2(const double * x, double * y, int n) {
+    log10Scalar(x, y, n);
+}
+
+void PatchMath::expAVX512(const double * x, double * y, int n) {
+    expScalar(x, y, n);
+}
+
+void PatchMath::log10AVX512(const double * x, double * y, int n) {
+    log10Scalar(x, y, n);
+}
+
+#endif
+
+PatchMath::Kernels PatchMath::select() {
+#ifdef PATCHMATH_HAS_SIMD
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")) {
+        Kernels kernels = {"AVX-512", expAVX512, log10AVX512};
+        return kernels;
+    }
+    if(__builtin_cpu_supports("avx2")) {
+        Kernels kernels = {"AVX2", expAVX2, log10AVX2};
+        return kernels;
+    }
+#endif
+#ifdef PATCH_MATH_LIBM
+    Kernels kernels = {"libm", expScalar, log10Scalar};
+#else
+    Kernels kernels = {"scalar", expScalar, log10Scalar};
+#endif
+    return kernels;
+}
+
+const PatchMath::Kernels & PatchMath::selected() {
+    static const Kernels kernels = select();
+    return kernels;
+}
+
+uint64_t PatchMath::ulpDistance(double a, double b) {
+    //Map the bits onto a line where neighbouring doubles are neighbouring integers
+    int64_t aBits = (int64_t)toBits(a);
+    int64_t bBits = (int64_t)toBits(b);
+    if(aBits < 0) {
+        aBits = std::numeric_limits<int64_t>::min() - aBits;
+    }
+    if(bBits < 0) {
+        bBits = std::numeric_limits<int64_t>::min() - bBits;
+    }
+    return aBits > bBits ? (uint64_t)aBits - (uint64_t)bBits : (uint64_t)bBits - (uint64_t)aBits;
+}
+
+namespace {
+
+void printComparison(const char * name, PatchMath::ArrayFunction kernel, double (*reference)(double),
+                     const double * arguments, int count)
+{
+    std::vector<double> results(count);
+    kernel(arguments, results.data(), count);
+
+    uint64_t maxUlp = 0;
+    double maxRelative = 0.0;
+    double worstArgument = 0.0;
+    for(int i = 0; i < count; i++) {
+        double expected = reference(arguments[i]);
+        if(std::isnan(expected) && std::isnan(results[i])) {
+            continue;
+        }
+
+        uint64_t ulp = PatchMath::ulpDistance(results[i], expected);
+        if(ulp > maxUlp) {
+            maxUlp = ulp;
+            worstArgument = arguments[i];
+        }
+        if(expected != 0.0) {
+            maxRelative = std::max(maxRelative, std::fabs((results[i] - expected) / expected));
+        }
+    }
+
+    std::cout << "    " << name << ": " << count << " values, max " << maxUlp << " ulp";
+    if(maxUlp > 0) {
+        std::cout << " at " << worstArgument;
+    }
+    std::cout << ", max relative error " << maxRelative << std::endl;
+}
+
+double libmExp(double x) {
+    return std::exp(x);
+}
+
+double libmLog10(double x) {
+    return std::log10(x);
+}
+
+}
+
+void PatchMath::compareWithLibm(const Kernels & kernels, const double * expArguments, int expCount,
+                                const double * log10Arguments, int log10Count)
+{
+    std::cout << "Patch math (" << kernels.name << ") against libm:" << std::endl;
+    printComparison("exp", kernels.exp, libmExp, expArguments, expCount);
+    printComparison("log10", kernels.log10, libmLog10, log10Arguments, log10Count);
+}
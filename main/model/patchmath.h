@@ -0,0 +1,95 @@
+#ifndef PATCHMATH_H
+#define PATCHMATH_H
+
+#include <cmath>
+#include <iostream>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief The exp and log10 used by the patch computations, with scalar, AVX2 and AVX-512
+ *        kernels that work through a whole array of arguments at once.
+ *
+ *        Every kernel does the same operations in the same order, so a value comes out
+ *        the same bits whichever kernel computed it and a patch updated one at a time
+ *        matches one updated as part of an array.
+ *          exp   within 1 ulp of libm for -708.39 <= x <= 709.78, the range with normal
+ *                results
+ *          log10 within 1 ulp of the correctly rounded result for positive normal x.  libm's
+ *                log10 is itself up to 2 ulp out, so the two can differ by more.
+ *        Arguments outside those ranges, including NaN and infinities, are passed on to
+ *        libm.
+ *
+ *        Defining PATCH_MATH_LIBM builds every kernel on libm instead, so a whole run can
+ *        be compared against one using libm.
+ */
+namespace PatchMath {
+
+    /**
+     * @brief Scalar exp, the reference for the array kernels
+     */
+    double exp(double x);
+
+    /**
+     * @brief Scalar log10, the reference for the array kernels
+     */
+    double log10(double x);
+
+    /**
+     * @brief Signature shared by the array kernels, y[i] = f(x[i]) for i < n.  x and y may
+     *        be the same array.
+     */
+    typedef void (*ArrayFunction)(const double * x, double * y, int n);
+
+    void expScalar(const double * x, double * y, int n);
+    void log10Scalar(const double * x, double * y, int n);
+
+    /**
+     * @brief AVX2 versions of the kernels.  Only call these if the cpu supports it,
+     *        select() takes care of checking.
+     */
+    void expAVX2(const double * x, double * y, int n);
+    void log10AVX2(const double * x, double * y, int n);
+
+    /**
+     * @brief AVX-512 versions of the kernels.  Only call these if the cpu supports it,
+     *        select() takes care of checking.
+     */
+    void expAVX512(const double * x, double * y, int n);
+    void log10AVX512(const double * x, double * y, int n);
+
+    /**
+     * @brief One set of array kernels and a printable name for logging
+     */
+    struct Kernels {
+        const char * name;
+        ArrayFunction exp;
+        ArrayFunction log10;
+    };
+
+    /**
+     * @brief Returns the fastest kernels the running cpu supports
+     */
+    Kernels select();
+
+    /**
+     * @brief Returns the kernels picked by select() the first time it is called
+     */
+    const Kernels & selected();
+
+    /**
+     * @brief Returns how many representable doubles apart two values are, 0 if they are
+     *        the same.  Values of different signs count the doubles between them and zero.
+     */
+    uint64_t ulpDistance(double a, double b);
+
+    /**
+     * @brief Runs the kernels over the arguments and prints the largest differences from
+     *        libm, in ulp and relative to the libm value.
+     */
+    void compareWithLibm(const Kernels & kernels, const double * expArguments, int expCount,
+                         const double * log10Arguments, int log10Count);
+
+}
+
+#endif // PATCHMATH_H
@@ -9,6 +9,7 @@ River::River(Configuration & newConfig, HydroFileDict & hydroFileDict)
 
     config = newConfig;
 
+    hydroDict = &hydroFileDict;
     currHydroData = NULL;
     currWaterTemp = -1.0;
     currPAR = -1;
@@ -16,70 +17,61 @@ River::River(Configuration & newConfig, HydroFileDict & hydroFileDict)
     width = hydroFileDict.getMaxWidth();
     height = hydroFileDict.getMaxHeight();
 
-}
-
-//TODO This function is relatively slow because of many hashtable lookups
-// in HydroFile class.  Consider pros and cons of using a grid instead.
-void River::setCurrentHydroData(HydroData *newHydroData) {
-    HydroFile * newHydroFile = &newHydroData->hydroFile;
-    HydroFile * currHydroFile = NULL;
-
-    int hydroIndex = newHydroFile->getHydroIndex();
-    if(currHydroData != NULL) {
-        currHydroFile = &currHydroData->hydroFile;
-    }
-
-    for (int i = 0; i < p.getSize(); i++ ) {
-        int x = p.pxcor[i];
-        int y = p.pycor[i];
-
-        if(newHydroFile->patchExists(x,y)){
-            double depth = newHydroFile->getDepth(x,y);
-            QVector2D flowVector = newHydroFile->getVector(x,y);
-            double flowX = flowVector.x();
-            double flowY = flowVector.y();
-
-            //TODO Replace this line with flowVector.length() once we know if it is correct to do so.
-            double flowMagnitude = newHydroFile->getFileVelocity(x,y);
-
-            p.hasWater[i] = true;
-            p.depth[i] = depth;
-            p.flowX[i] = flowX;
-            p.flowY[i] = flowY;
-            p.flowMagnitude[i] = flowMagnitude;
-            p.isInput[i] = newHydroFile->isInput(x,y);
-            p.isOutput[i] = newHydroFile->isOutput(x,y);
-
-        } else {
-            p.hasWater[i] = false;
-            p.depth[i] = 0.0;
-            p.flowX[i] = 0.0;
-            p.flowY[i] = 0.0;
-            p.flowMagnitude[i] = 0.0;
-            p.isInput[i] = false;
-            p.isOutput[i] = false;
+    currFlowOperator = NULL;
+    currRemainderFlowOperator = NULL;
+    flowStepsPerHour = config.hourlyFlow ? 1 : FLOW_ITERATIONS_PER_HOUR / config.flowPrecomputeDepth;
+    transport = FlowKernel::selectTransport();
+    cout << "Flow kernel: " << FlowKernel::getName(transport) << endl;
+    cout << "Patch math: " << PatchMath::selected().name << endl;
+    processBiology = p.hasFluxes() ? PatchComputation::processPatchesReference
+                                   : PatchComputation::processPatchesFused;
+
+    //Plan every switch between hydromaps the run will make so switching is just copies
+    for(int i = 1; i < config.hydroMapsSelected.size(); i++) {
+        HydroData * previousHydroData = hydroFileDict[config.hydroMapsSelected[i - 1]];
+        HydroData * hydroData = hydroFileDict[config.hydroMapsSelected[i]];
+        if(previousHydroData != hydroData) {
+            getHydroTransition(previousHydroData, hydroData);
         }
+    }
+}
 
-        // update miscellanous variables inside the patch
+River::~River() {
+    for(QHash<HydroData *, FlowOperator *>::iterator i = flowOperators.begin(); i != flowOperators.end(); i++) {
+        delete *i;
+    }
+    for(QHash<HydroData *, FlowOperator *>::iterator i = remainderFlowOperators.begin(); i != remainderFlowOperators.end(); i++) {
+        delete *i;
+    }
+    for(QHash<HydroTransitionKey, HydroTransition *>::iterator i = hydroTransitions.begin(); i != hydroTransitions.end(); i++) {
+        delete *i;
+    }
+}
 
-        double current_depth = 0.0;
-        if(currHydroFile != NULL && currHydroFile->patchExists(x,y)){
-            current_depth = currHydroFile->getDepth(x,y);
-        }
+void River::setCurrentHydroData(HydroData *newHydroData) {
+    newHydroData->patchHydroData.setTurbidity(PatchComputation::getTurbidity(config));
+    const PatchHydroData & newPatchHydroData = newHydroData->patchHydroData;
+    newPatchHydroData.apply(p);
+
+    //non-input -> input
+    int hydroIndex = newHydroData->hydroFile.getHydroIndex();
+    for(int n = 0; n < newPatchHydroData.inputPatches.size(); n++) {
+        int i = newPatchHydroData.inputPatches[n];
+        p.DOC[i] = config.docInput[hydroIndex];
+        p.POC[i] = config.pocInput[hydroIndex];
+        p.phyto[i] = config.phytoInput[hydroIndex];
+        p.waterdecomp[i] = config.waterdecompInput[hydroIndex];
+    }
 
-        //non-input -> input
-        if(p.isInput[i]){
-            p.DOC[i] = config.docInput[hydroIndex];
-            p.POC[i] = config.pocInput[hydroIndex];
-            p.phyto[i] = config.phytoInput[hydroIndex];
-            p.waterdecomp[i] = config.waterdecompInput[hydroIndex];
-        }
+    //input -> non-input
+    //TODO: If we start using one riverIO file per hydromap this transition must be handled.
 
-        //input -> non-input
-        //TODO: If we start using one riverIO file per hydromap this transition must be handled.
+    if(currHydroData != NULL) {
+        const HydroTransition & transition = getHydroTransition(currHydroData, newHydroData);
 
         // Water -> Land
-        if (current_depth > 0.0 && p.depth[i] == 0.0) {
+        for(int n = 0; n < transition.dryingPatches.size(); n++) {
+            int i = transition.dryingPatches[n];
             p.detritus[i] += p.DOC[i] + p.POC[i] + p.phyto[i] +
                     p.macro[i] + p.waterdecomp[i] +
                     p.seddecomp[i] + p.herbivore[i] + p.sedconsumer[i] + p.consumer[i];
@@ -98,12 +90,52 @@ void River::setCurrentHydroData(HydroData *newHydroData) {
         //TODO: Instead of handling this here, process detritus daily in land patches
         //    via processPatches and with a potentially diff percentage.
         // Land -> Water
-        if (currHydroFile != NULL && current_depth == 0.0 && p.depth[i] > 0.0) {
-            p.detritus[i] *= 0.5;
+        for(int n = 0; n < transition.wettingPatches.size(); n++) {
+            p.detritus[transition.wettingPatches[n]] *= 0.5;
         }
     }
 
     currHydroData = newHydroData;
+
+    if(!flowOperators.contains(newHydroData)) {
+        buildFlowOperators(*newHydroData);
+
+        size_t bytes = flowOperators[newHydroData]->getBytes();
+        if(remainderFlowOperators.contains(newHydroData)) {
+            bytes += remainderFlowOperators[newHydroData]->getBytes();
+        }
+        hydroDict->setFlowOperatorBytes(newHydroData, bytes);
+    }
+    currFlowOperator = flowOperators[newHydroData];
+    currRemainderFlowOperator = remainderFlowOperators.value(newHydroData, NULL);
+
+    releaseFlowOperators();
+
+    if(config.validatePatchMath) {
+        comparePatchMath(newHydroData->hydroFile);
+    }
+}
+
+void River::releaseFlowOperators() {
+    QList<HydroData *> built = flowOperators.keys();
+    for(int i = 0; i < built.size(); i++) {
+        HydroData * hydroData = built[i];
+        if(hydroData == currHydroData || hydroDict->hasFlows(hydroData)) {
+            continue;
+        }
+
+        delete flowOperators.take(hydroData);
+        delete remainderFlowOperators.take(hydroData);
+        hydroDict->setFlowOperatorBytes(hydroData, 0);
+    }
+}
+
+const HydroTransition & River::getHydroTransition(HydroData * from, HydroData * to) {
+    HydroTransitionKey key(from, to);
+    if(!hydroTransitions.contains(key)) {
+        hydroTransitions.insert(key, new HydroTransition(from->patchHydroData, to->patchHydroData));
+    }
+    return *hydroTransitions[key];
 }
 
 void River::setCurrentWaterTemperature(double newTemp) {
@@ -126,86 +158,237 @@ int River::getNewGrowthRate(int temp) {
     return growthRates[temp];
 }
 
-void River::flow(Grid<FlowData> * source, Grid<FlowData> * dest) {
-    copyFlowData(*dest);
-    copyFlowData(*source);
-
-    for (int t = 0; t < ITERATIONS_TO_FLOW_RIVER; t++)
+void River::flow() {
+    for (int t = 0; t < flowStepsPerHour; t++)
     {
-        std::swap(source, dest);
-        flowSingleTimestep(*source, *dest, config);
+        transport(*currFlowOperator, p.hasWater, p.flowStocks, p.flowStocksBuffer);
+        p.swapFlowStocks();
     }
 
-    storeFlowData(*dest);
+    if(currRemainderFlowOperator != NULL) {
+        transport(*currRemainderFlowOperator, p.hasWater, p.flowStocks, p.flowStocksBuffer);
+        p.swapFlowStocks();
+    }
 }
 
-void River::copyFlowData(Grid<FlowData> & flowData) {
-    for(int i = 0; i < p.getSize(); i++) {
-        int x = p.pxcor[i];
-        int y = p.pycor[i];
+void River::buildFlowOperators(HydroData & hydroData) {
+    HydroFile & hydroFile = hydroData.hydroFile;
+    int steps = FLOW_ITERATIONS_PER_HOUR / config.flowPrecomputeDepth;
+
+    FlowOperator * stepOperator = new FlowOperator(hydroFile, hydroData.carbonFlowMap, p);
+    FlowOperator * remainderOperator = NULL;
+    if(FLOW_ITERATIONS_PER_HOUR % config.flowPrecomputeDepth != 0) {
+        remainderOperator = new FlowOperator(hydroFile, hydroData.remainderFlowMap, p);
+    }
+
+    if(!config.hourlyFlow) {
+        if(config.compactFlow) {
+            compactFlowOperators(hydroFile, *stepOperator, remainderOperator, steps);
+        }
+        reportFlowOperators(hydroFile, *stepOperator, remainderOperator, steps);
+
+        flowOperators.insert(&hydroData, stepOperator);
+        if(remainderOperator != NULL) {
+            remainderFlowOperators.insert(&hydroData, remainderOperator);
+        }
+        return;
+    }
 
-        flowData(x,y).hasWater    = p.hasWater[i];
-        flowData(x,y).depth       = p.depth[i];
-        flowData(x,y).velocity    = p.flowMagnitude[i];
-        flowData(x,y).px_vector   = p.flowX[i];
-        flowData(x,y).py_vector   = p.flowY[i];
-        flowData(x,y).DOC         = p.DOC[i];
-        flowData(x,y).POC         = p.POC[i];
-        flowData(x,y).phyto       = p.phyto[i];
-        flowData(x,y).waterdecomp = p.waterdecomp[i];
+    FlowOperator * hourlyOperator = new FlowOperator(*stepOperator);
+    for(int t = 1; t < steps; t++) {
+        *hourlyOperator = stepOperator->multiply(*hourlyOperator, PRECOMPUTED_FLOW_TRIM_THRESHOLD);
+    }
+    if(remainderOperator != NULL) {
+        *hourlyOperator = remainderOperator->multiply(*hourlyOperator, PRECOMPUTED_FLOW_TRIM_THRESHOLD);
+    }
 
+    reportHourlyOperator(hydroFile, *stepOperator, remainderOperator, *hourlyOperator);
+    if(config.compactFlow) {
+        compactFlowOperators(hydroFile, *hourlyOperator, NULL, 1);
     }
+    reportFlowOperators(hydroFile, *hourlyOperator, NULL, 1);
+
+    delete stepOperator;
+    delete remainderOperator;
+    flowOperators.insert(&hydroData, hourlyOperator);
 }
 
-void River::storeFlowData(Grid<FlowData> & flowData) {
-    for(int i = 0; i < p.getSize(); i++) {
-        int x = p.pxcor[i];
-        int y = p.pycor[i];
+void River::reportFlowOperators(const HydroFile & hydroFile, const FlowOperator & stepOperator,
+                                const FlowOperator * remainderOperator, int steps) const
+{
+    int totalSources = stepOperator.getNonZeros();
+    size_t bytes = stepOperator.getBytes();
+    size_t bytesPerHour = steps * stepOperator.getBytes();
+    if(remainderOperator != NULL) {
+        totalSources += remainderOperator->getNonZeros();
+        bytes += remainderOperator->getBytes();
+        bytesPerHour += remainderOperator->getBytes();
+    }
 
-        p.DOC[i]         = flowData(x,y).DOC;
-        p.POC[i]         = flowData(x,y).POC;
-        p.phyto[i]       = flowData(x,y).phyto;
-        p.waterdecomp[i] = flowData(x,y).waterdecomp;
+    //Flow scratch stocks so the river itself is untouched.  The estimate times a single
+    //warmed up flow of each operator, the measurement times a whole hour.
+    QVector<double> source(FLOW_STOCKS * p.getSize(), 1.0);
+    QVector<double> dest(FLOW_STOCKS * p.getSize());
+    transport(stepOperator, p.hasWater, source.data(), dest.data());
+
+    double start = omp_get_wtime();
+    transport(stepOperator, p.hasWater, source.data(), dest.data());
+    double estimated = (omp_get_wtime() - start) * steps;
+    if(remainderOperator != NULL) {
+        start = omp_get_wtime();
+        transport(*remainderOperator, p.hasWater, source.data(), dest.data());
+        estimated += omp_get_wtime() - start;
     }
+
+    start = omp_get_wtime();
+    for(int t = 0; t < steps; t++) {
+        transport(stepOperator, p.hasWater, source.data(), dest.data());
+        std::swap(source, dest);
+    }
+    if(remainderOperator != NULL) {
+        transport(*remainderOperator, p.hasWater, source.data(), dest.data());
+    }
+    double measured = omp_get_wtime() - start;
+
+    cout << "Flow operator for: " << hydroFile.getFileName().toStdString() << endl;
+    cout << "    " << steps << " flows per hour";
+    if(remainderOperator != NULL) {
+        cout << " plus one of " << FLOW_ITERATIONS_PER_HOUR % config.flowPrecomputeDepth << " minutes";
+    }
+    cout << endl;
+    cout << "    sources: " << totalSources << ", bytes: " << bytes
+         << " (" << bytesPerHour << " read per hour)" << endl;
+    cout << "    flow time per hour: estimated " << estimated * 1000.0 << " ms, measured "
+         << measured * 1000.0 << " ms" << endl;
 }
 
-void River::flowSingleTimestep(Grid<FlowData> &source, Grid<FlowData> &dest, Configuration &config) {
-    CarbonFlowMap * carbonFlowMap = &currHydroData->carbonFlowMap;
+void River::reportHourlyOperator(const HydroFile & hydroFile, const FlowOperator & stepOperator,
+                                 const FlowOperator * remainderOperator,
+                                 const FlowOperator & hourlyOperator) const
+{
+    //Flow one unit of carbon from every patch through the hour both ways and compare
+    QVector<double> stepped(p.getSize(), 1.0);
+    QVector<double> scratch(p.getSize());
+    for(int t = 0; t < FLOW_ITERATIONS_PER_HOUR / config.flowPrecomputeDepth; t++) {
+        stepOperator.apply(stepped.data(), scratch.data());
+        std::swap(stepped, scratch);
+    }
+    if(remainderOperator != NULL) {
+        remainderOperator->apply(stepped.data(), scratch.data());
+        std::swap(stepped, scratch);
+    }
 
-    SourceArrays sourceData = carbonFlowMap->getSourceArrays();
-    #pragma omp parallel for
+    QVector<double> composed(p.getSize(), 1.0);
+    hourlyOperator.apply(composed.data(), scratch.data());
+    std::swap(composed, scratch);
+
+    double steppedMass = 0.0;
+    double composedMass = 0.0;
+    double maxPatchError = 0.0;
     for(int i = 0; i < p.getSize(); i++) {
-        if( !p.hasWater[i] ) {
-            continue;
-        }
+        steppedMass += stepped[i];
+        composedMass += composed[i];
+        maxPatchError = max(maxPatchError, fabs(stepped[i] - composed[i]));
+    }
+
+    double fillIn = 0.0;
+    if(stepOperator.getNonZeros() > 0) {
+        fillIn = (double)hourlyOperator.getNonZeros() / stepOperator.getNonZeros();
+    }
+    double massError = 0.0;
+    if(steppedMass > 0.0) {
+        massError = fabs(composedMass - steppedMass) / steppedMass;
+    }
+
+    cout << "Hourly flow operator for: " << hydroFile.getFileName().toStdString() << endl;
+    cout << "    sources: " << stepOperator.getNonZeros() << " -> " << hourlyOperator.getNonZeros()
+         << " (fill-in " << fillIn << "x)" << endl;
+    cout << "    carbon after one hour: stepped " << steppedMass << ", composed " << composedMass
+         << ", relative error " << massError << ", max patch error " << maxPatchError << endl;
+}
+
+void River::comparePatchMath(const HydroFile & hydroFile) const {
+    double turbidity = PatchComputation::getTurbidity(config);
+
+    //The same arguments PatchHydroData::setTurbidity and processPatchesFused give the kernels
+    QVector<double> expArguments;
+    QVector<double> log10Arguments;
+    const QVector<int> & activePatches = p.getActivePatches();
+    for(int n = 0; n < activePatches.size(); n++) {
+        int i = activePatches[n];
+
+        double phyto = p.phyto[i];
+        Utility::boundValue(phyto, 0.001, 900000.0);
 
-        int x = p.pxcor[i];
-        int y = p.pycor[i];
+        expArguments.append((-1 * p.depth[i]) * turbidity);
+        expArguments.append(-1 * phyto * config.kPhyto * p.depth[i]);
+        log10Arguments.append(((p.flowMagnitude[i] / 40.0 ) + .0001) + 1.0);
+        log10Arguments.append(p.flowMagnitude[i] / 40.0 + 0.01);
+    }
+
+    cout << "Patch math for: " << hydroFile.getFileName().toStdString() << endl;
+    PatchMath::compareWithLibm(PatchMath::selected(), expArguments.constData(), expArguments.size(),
+                               log10Arguments.constData(), log10Arguments.size());
+}
+
+void River::compactFlowOperators(const HydroFile & hydroFile, FlowOperator & stepOperator,
+                                 FlowOperator * remainderOperator, int steps) const
+{
+    if(!config.validateCompactFlow) {
+        stepOperator.compact();
+        if(remainderOperator != NULL) {
+            remainderOperator->compact();
+        }
+        return;
+    }
 
-        double DOC = 0.0;
-        double POC = 0.0;
-        double waterdecomp = 0.0;
-        double phyto = 0.0;
+    //Flow one unit of every stock from every patch through the hour with both encodings
+    QVector<double> reference(FLOW_STOCKS * p.getSize(), 1.0);
+    QVector<double> compacted(FLOW_STOCKS * p.getSize(), 1.0);
+    QVector<double> scratch(FLOW_STOCKS * p.getSize());
+    for(int t = 0; t < steps; t++) {
+        transport(stepOperator, p.hasWater, reference.data(), scratch.data());
+        std::swap(reference, scratch);
+    }
+    if(remainderOperator != NULL) {
+        transport(*remainderOperator, p.hasWater, reference.data(), scratch.data());
+        std::swap(reference, scratch);
+    }
 
+    stepOperator.compact();
+    if(remainderOperator != NULL) {
+        remainderOperator->compact();
+    }
 
-        int currOffset = sourceData.getOffset(x,y);
-        int numSources = sourceData.getSize(x,y);
-        for(int sourceIndex = 0; sourceIndex < numSources; sourceIndex++) {
-            int sourceX = sourceData.x[currOffset + sourceIndex];
-            int sourceY = sourceData.y[currOffset + sourceIndex];
-            double sourceAmount = sourceData.amount[currOffset + sourceIndex];
+    for(int t = 0; t < steps; t++) {
+        transport(stepOperator, p.hasWater, compacted.data(), scratch.data());
+        std::swap(compacted, scratch);
+    }
+    if(remainderOperator != NULL) {
+        transport(*remainderOperator, p.hasWater, compacted.data(), scratch.data());
+        std::swap(compacted, scratch);
+    }
 
-            DOC += source(sourceX,sourceY).DOC * sourceAmount;
-            POC += source(sourceX,sourceY).POC * sourceAmount;
-            waterdecomp += source(sourceX,sourceY).waterdecomp * sourceAmount;
-            phyto += source(sourceX,sourceY).phyto * sourceAmount;
+    double referenceMass = 0.0;
+    double compactedMass = 0.0;
+    double maxRelativeError = 0.0;
+    for(int i = 0; i < reference.size(); i++) {
+        referenceMass += reference[i];
+        compactedMass += compacted[i];
+        if(reference[i] > 0.0) {
+            maxRelativeError = max(maxRelativeError, fabs(compacted[i] - reference[i]) / reference[i]);
         }
+    }
 
-        dest(x,y).DOC = DOC;
-        dest(x,y).POC = POC;
-        dest(x,y).waterdecomp = waterdecomp;
-        dest(x,y).phyto = phyto;
+    double massError = 0.0;
+    if(referenceMass > 0.0) {
+        massError = fabs(compactedMass - referenceMass) / referenceMass;
     }
+
+    cout << "Compact flow operator for: " << hydroFile.getFileName().toStdString() << endl;
+    cout << "    carbon after one hour: double " << referenceMass << ", compact " << compactedMass
+         << ", relative error " << massError << ", max patch relative error "
+         << maxRelativeError << endl;
 }
 
 bool River::is_valid_patch(int x, int y) {
@@ -217,10 +400,9 @@ bool River::is_valid_patch(int x, int y) {
 Statistics River::generateStatistics() {
     Statistics stats;
 
-    for(int i = 0; i < p.getSize(); i++) {
-        if(!p.hasWater[i] /*|| p.isInput[i]*/) {
-            continue;
-        }
+    const QVector<int> & activePatches = p.getActivePatches();
+    for(int n = 0; n < activePatches.size(); n++) {
+        int i = activePatches[n];
 
         stats.waterPatches++;
 
@@ -335,12 +517,10 @@ void River::saveCSV(QString displayedStock, int currentDay, QString currHydroFil
     double assimilation;
     double detritus, DOC, POC, waterdecomp, seddecomp, macro, phyto, herbivore, sedconsumer, peri, consumer;
 
-    for(int i = 0; i < p.getSize(); i++) {
-        //Skip if cell doesn't exist or is land
-        if(!p.hasWater[i]) {
-            continue;
-        }
-
+    //Only cells with water are saved
+    const QVector<int> & activePatches = p.getActivePatches();
+    for(int n = 0; n < activePatches.size(); n++) {
+        int i = activePatches[n];
 
         depth = p.depth[i];
         velocity = p.flowMagnitude[i];
@@ -369,6 +549,36 @@ void River::saveCSV(QString displayedStock, int currentDay, QString currHydroFil
 
     }
     fclose(f);
+
+    if(p.hasFluxes()) {
+        saveFluxCSV("./results/data/flux_data_" + dateAndTime + ".csv");
+    }
+}
+
+void River::saveFluxCSV(const QString & filename) const {
+    FILE* f = fopen(filename.toStdString().c_str(), "w");
+    if (f == NULL) {
+        cout << "Failed to open the flux csv file for write." << endl;
+        exit(1);
+    }
+
+    fprintf(f, "# pxcor,pycor");
+    for(int flux = 0; flux < PatchCollection::getFluxCount(); flux++) {
+        fprintf(f, ",%s", PatchCollection::getFluxName(flux));
+    }
+    fprintf(f, "\n");
+
+    const QVector<int> & activePatches = p.getActivePatches();
+    for(int n = 0; n < activePatches.size(); n++) {
+        int i = activePatches[n];
+
+        fprintf(f, "%d,%d", p.pxcor[i], p.pycor[i]);
+        for(int flux = 0; flux < PatchCollection::getFluxCount(); flux++) {
+            fprintf(f, ",%f", p.getFlux(flux)[i]);
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
 }
 
 void River::generateImages(QVector<QImage> &images, QVector<QString> & stockNames,
@@ -384,11 +594,10 @@ void River::generateImages(QVector<QImage> &images, QVector<QString> & stockName
             images[imageIndex].fill(color.rgb());
         }
 
+        const QVector<int> & activePatches = p.getActivePatches();
         #pragma omp for
-        for(int i = 0; i < p.getSize(); i++){
-            if(!p.hasWater[i]) {
-                continue;
-            }
+        for(int n = 0; n < activePatches.size(); n++){
+            int i = activePatches[n];
 
             int x = p.pxcor[i];
             int y = p.pycor[i];
@@ -470,36 +679,16 @@ QColor River::getHeatMapColor(double carbonValue, double avgVal, double maxVal)
 }
 
 void River::processPatches() {
+    //Work out everything that is the same for every patch this hour up front
+    PatchComputation::HourlyForcing forcing = PatchComputation::getHourlyForcing(config, currPAR, currWaterTemp,
+                                                                                 currGrowthRate);
+    if(currHydroData != NULL && currHydroData->patchHydroData.turbidity != forcing.turbidity) {
+        currHydroData->patchHydroData.setTurbidity(forcing.turbidity);
+        currHydroData->patchHydroData.applyLightAttenuation(p);
+    }
+
     #pragma omp parallel
     {
-        PatchComputation::updatePatches(p, config, currPAR);
-        PatchComputation::macro(p, config, currPAR, currWaterTemp, currGrowthRate);
-        PatchComputation::phyto(p, config, currPAR, currWaterTemp);
-        PatchComputation::herbivore(p, config);
-        PatchComputation::waterDecomp(p, config);
-        PatchComputation::sedDecomp(p, config);
-        PatchComputation::sedConsumer(p, config);
-        PatchComputation::consumer(p, config);
-        PatchComputation::DOC(p, config);
-        PatchComputation::POC(p);
-        PatchComputation::detritus(p, config);
-
-        #pragma omp for
-        for(int i = 0; i < p.getSize(); i++) {
-            //Only process patches if they currently contain water
-            if(!p.hasWater[i]) {
-                continue;
-            }
-
-            PatchComputation::predPhyto(p, i);
-            PatchComputation::predHerbivore(p, i);
-            PatchComputation::predSedDecomp(p, i);
-            PatchComputation::predWaterDecomp(p, i);
-            PatchComputation::predSedConsumer(p, i);
-            PatchComputation::predDetritus(p, i);
-            PatchComputation::predDOC(p, i);
-            PatchComputation::predPOC(p, i);
-            PatchComputation::predConsum(p, i);
-        }
+        processBiology(p, config, forcing);
     }
 }
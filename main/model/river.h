@@ -8,20 +8,26 @@
 #include <QColor>
 #include <QDateTime>
 #include <QFile>
+#include <QHash>
 #include <QImage>
 #include <QImageWriter>
 #include <QMutex>
+#include <QPair>
 #include <QString>
 #include <QTextStream>
+#include <QVector>
 #include <QVector2D>
 
 #include "configuration.h"
 #include "constants.h"
-#include "flowdata.h"
+#include "flowkernel.h"
+#include "flowoperator.h"
 #include "hydrofile.h"
 #include "hydrofiledict.h"
+#include "hydrotransition.h"
 #include "patchcollection.h"
 #include "patchcomputation.h"
+#include "patchmath.h"
 #include "statistics.h"
 
 using std::ofstream;
@@ -43,6 +49,11 @@ class River {
          */
         River(Configuration & newConfig, HydroFileDict & hydroFileDict);
 
+        /**
+         * @brief Destructor, frees the flow operators and transitions built for each hydromap
+         */
+        ~River();
+
 
         /**
          * @brief Sets the hydromap to use in future calculations
@@ -76,11 +87,12 @@ class River {
         /**
          * @brief Makes the river flow for a simulated hour
          */
-        void flow(Grid<FlowData> * source, Grid<FlowData> * dest);
+        void flow();
 
 
         /**
-         * @brief Outputs the patch data to a csv file
+         * @brief Outputs the patch data to a csv file, and the fluxes to a second one
+         *        when the config saves them
          * @param outputPath Location to save the file
          * @param filenamePrefix Prefix for filename
          */
@@ -106,15 +118,68 @@ class River {
 
     private:
         /**
-         * @brief Helper function for flow that handles flowing fow a single timestep
+         * @brief Outputs every water patch's fluxes and limitations to a csv file
+         * @param filename The file to write
          */
-        void flowSingleTimestep(Grid<FlowData> & source, Grid<FlowData> & dest, Configuration & config);
+        void saveFluxCSV(const QString & filename) const;
+
+        /**
+         * @brief Builds the flow operators for a hydromap.  If the config asks for hourly
+         *        flow the precomputed operators are composed into one covering a full hour.
+         * @param hydroData The hydromap and carbonFlowMaps to convert
+         */
+        void buildFlowOperators(HydroData & hydroData);
+
+        /**
+         * @brief Prints the size of a hydromap's flow operators and how long they take to
+         *        flow the river for an hour, estimated from a single flow and measured.
+         * @param steps Number of times stepOperator is applied per hour
+         */
+        void reportFlowOperators(const HydroFile & hydroFile, const FlowOperator & stepOperator,
+                                 const FlowOperator * remainderOperator, int steps) const;
+
+        /**
+         * @brief Prints the fill-in and mass conservation error of an hourly operator
+         *        compared to stepping the precomputed operators through the hour.
+         */
+        void reportHourlyOperator(const HydroFile & hydroFile, const FlowOperator & stepOperator,
+                                  const FlowOperator * remainderOperator,
+                                  const FlowOperator & hourlyOperator) const;
+
+        /**
+         * @brief Switches a hydromap's flow operators to float weights.  If the config asks
+         *        for validation the hour is flowed before and after and the differences
+         *        printed.
+         * @param steps Number of times stepOperator is applied per hour
+         */
+        void compactFlowOperators(const HydroFile & hydroFile, FlowOperator & stepOperator,
+                                  FlowOperator * remainderOperator, int steps) const;
+
+        /**
+         * @brief Prints how far the selected PatchMath kernels are from libm over the exp
+         *        and log10 arguments of a hydromap's patches
+         */
+        void comparePatchMath(const HydroFile & hydroFile) const;
+
+        /**
+         * @brief Frees the flow operators of hydromaps whose flows the HydroFileDict has
+         *        released to stay within the flow memory budget.  They are rebuilt if the
+         *        hydromap is used again.
+         */
+        void releaseFlowOperators();
+
+        /**
+         * @brief Returns the patches that change when switching between two hydromaps,
+         *        building the list the first time the pair is asked for
+         */
+        const HydroTransition & getHydroTransition(HydroData * from, HydroData * to);
 
-        //Temp functions, will be replaced in move to carbonFlowMap
-        void copyFlowData(Grid<FlowData> & flowData);
-        void storeFlowData(Grid<FlowData> & flowData);
         bool is_valid_patch(int x, int y);
 
+        //Rivers hold pointers to per-hydromap flow operators and should not be copied
+        River(const River & other);
+        River & operator=(const River & rhs);
+
         /**
          * @brief Computes the color to draw based on the patch's
          *        value compared to all other patches.  Resulting image
@@ -132,6 +197,23 @@ class River {
 
         //Points to an external hydroData object that exists for the duration of the simulation
         HydroData * currHydroData;
+        //The hydromaps' flows, which outlive the river
+        HydroFileDict * hydroDict;
+
+        //CSR flow operators over patch indices, built once per hydromap
+        QHash<HydroData *, FlowOperator *> flowOperators;
+        //Flows for the minutes left in each hour, only when the precompute depth does not divide it
+        QHash<HydroData *, FlowOperator *> remainderFlowOperators;
+        FlowOperator * currFlowOperator;
+        FlowOperator * currRemainderFlowOperator;
+
+        //The patches that change between each pair of hydromaps the river switches between
+        typedef QPair<HydroData *, HydroData *> HydroTransitionKey;
+        QHash<HydroTransitionKey, HydroTransition *> hydroTransitions;
+        int flowStepsPerHour;
+        FlowKernel::TransportFunction transport;
+        //Fused unless the fluxes are saved, processPatchesReference also fills them in
+        PatchComputation::ProcessFunction processBiology;
         double currWaterTemp;
         int currPAR;
 
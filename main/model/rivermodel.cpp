@@ -1,8 +1,6 @@
 #include "rivermodel.h"
 
 RiverModel::RiverModel() {
-    source = NULL;
-    dest = NULL;
 }
 
 RiverModel::RiverModel(const RiverModel &other) {
@@ -10,12 +8,10 @@ RiverModel::RiverModel(const RiverModel &other) {
 }
 
 RiverModel::~RiverModel(){
-    clear();
 }
 
 RiverModel & RiverModel::operator=(const RiverModel & rhs) {
     if(this != &rhs){
-        clear();
         copy(rhs);
     }
     return *this;
@@ -78,10 +74,15 @@ void RiverModel::run() {
         QString hydroFileName = modelConfig.hydroMapsSelected[hydroIndex];
         int daysToRunHydroFile = modelConfig.daysToRun[hydroIndex];
 
-        HydroData * currHydroData = hydroFileDict[hydroFileName];
+        if(!hydroFileDict.hasFlows(hydroFileName)) {
+            setStatusMessage("Waiting for flows to be precomputed for hydroFile: " + hydroFileName);
+            cout << "WAITING FOR FLOWS: " << hydroFileName.toStdString() << endl;
+        }
+        HydroData * currHydroData = hydroFileDict.waitForFlows(hydroFileName);
 
         setStatusMessage("Transitioning to hydroFile: " + hydroFileName);
         river.setCurrentHydroData(currHydroData);
+        hydroFileDict.printFlowCacheReport();
         cout << "RUNNING FILE: " << hydroFileName.toStdString() << " FOR " << daysToRunHydroFile << " DAYS" << endl;
 
         for(int dayOnHydroFile = 0; dayOnHydroFile < daysToRunHydroFile; dayOnHydroFile++) {
@@ -98,7 +99,7 @@ void RiverModel::run() {
                 printHourlyMessage(currentDay, hour);
                 river.setCurrentPAR( parValues[hoursElapsed] );
                 river.processPatches();
-                river.flow(source, dest);
+                river.flow();
                 statusMutex.lock();
                 modelStatus.updateProgress();
                 statusMutex.unlock();
@@ -176,7 +177,12 @@ void RiverModel::printHourlyMessage(int currentDay, int hourOfDay) {
 
 //TODO Move this to construct and add the "Big three" (CCtor, assignment operator, destructor)
 void RiverModel::initializeModel(const Configuration &config){
-    setStatusMessage("Loading HydroFiles and precomputing flows... please wait.");
+    if(!modelConfig.dischargeFile.isEmpty()) {
+        setStatusMessage("Scheduling hydromaps from discharge.");
+        initializeDischargeSchedule(modelConfig);
+    }
+
+    setStatusMessage("Loading HydroFiles and precomputing the first flows... please wait.");
     initializeHydroMaps(modelConfig);
 
     setStatusMessage("Loading water temperatures from file.");
@@ -185,10 +191,6 @@ void RiverModel::initializeModel(const Configuration &config){
     setStatusMessage("Loading par values from file.");
     initializePARValues(modelConfig);
 
-    // These are temp structures used in the flowing of the river.  Created
-    // here so they are not initialized and destroyed repeatedly.
-    initializeTempGrids(hydroFileDict);
-
     initializeImageVector(hydroFileDict);
     initializeStockNames();
 
@@ -231,7 +233,25 @@ void RiverModel::initializeHydroMaps(const Configuration &config) {
     for(int i = 0; i < config.hydroMapsSelected.size(); i++) {
         hydroFileNames.append(config.hydroMapsSelected[i]);
     }
-    hydroFileDict = HydroFileDict(hydroFileNames);
+    //Flows for all but the first hydrofile are precomputed while the simulation runs
+    hydroFileDict.load(hydroFileNames, config);
+}
+
+void RiverModel::initializeDischargeSchedule(Configuration &config) {
+    cout << "SCHEDULING HYDROFILES FROM DISCHARGE" << endl;
+    DischargeSchedule schedule(config.dischargeFile, config.hydroMapDirectory,
+                               config.minFlow, config.maxFlow);
+    if(schedule.getHydroMaps().isEmpty()) {
+        printf("Failed to schedule hydromaps from the discharge file");
+        exit(1);
+    }
+    schedule.apply(config);
+
+    cout << schedule.getDays() << " days of discharge run as " << config.hydroMapsSelected.size()
+         << " hydromap changes" << endl;
+    for(int i = 0; i < config.hydroMapsSelected.size(); i++) {
+        cout << "    " << config.hydroMapsSelected[i].toStdString() << ": " << config.daysToRun[i] << " days" << endl;
+    }
 }
 
 void RiverModel::initializeWaterTemps(const Configuration &config) {
@@ -268,15 +288,6 @@ void RiverModel::initializePARValues(const Configuration &config) {
 }
 
 
-void RiverModel::initializeTempGrids(HydroFileDict &hydroFileDict){
-    int width = hydroFileDict.getMaxWidth();
-    int height = hydroFileDict.getMaxHeight();
-    delete source;
-    delete dest;
-    source = new Grid<FlowData>(width, height);
-    dest = new Grid<FlowData>(width, height);
-}
-
 
 int RiverModel::getDaysToRun(const Configuration &config) {
     int daysToRun = 0;
@@ -346,13 +357,6 @@ void RiverModel::copy(const RiverModel & other) {
     displayedStock = other.displayedStock;
     stockNames = other.stockNames;
     averagesFilename = other.averagesFilename;
-    source = new Grid<FlowData>(*other.source);
-    dest = new Grid<FlowData>(*other.dest);
 
     images = other.images;
 }
-
-void RiverModel::clear() {
-    delete source;
-    delete dest;
-}
@@ -12,6 +12,7 @@
 
 #include "configuration.h"
 #include "constants.h"
+#include "dischargeschedule.h"
 #include "hydrofile.h"
 #include "hydrofiledict.h"
 #include "river.h"
@@ -81,9 +82,6 @@ class RiverModel {
         QMutex imageMutex;
         QMutex statusMutex;
 
-        Grid<FlowData> * source;
-        Grid<FlowData> * dest;
-
 
         /**
          * @brief Writes a status message to a terminal window every simulated hour
@@ -122,6 +120,13 @@ class RiverModel {
          */
         void initializeHydroMaps(const Configuration & config);
 
+        /**
+         * @brief Replaces the hydromaps and days to run with those of the discharge file.
+         *        Only the hydromaps the discharge uses are loaded afterwards.
+         * @param config Config used by the model
+         */
+        void initializeDischargeSchedule(Configuration & config);
+
         /**
          * @brief Initializes a QVector of water temperatures from file
          * @param config Config used by the model
@@ -134,12 +139,6 @@ class RiverModel {
          */
         void initializePARValues(const Configuration & config);
 
-        /**
-         * @brief Initializes temp Grids of flowdata structs for the River's flow routine
-         * @param hydroFileDict Hydrofiles so we know the width and height to use
-         */
-        void initializeTempGrids(HydroFileDict & hydroFileDict);
-
 
         /**
          * @brief Calculates the number of days the the simulation will run
@@ -162,7 +161,6 @@ class RiverModel {
         void setStatusMessage(QString message);
 
         void copy(const RiverModel & other);
-        void clear();
 
 };
 #endif
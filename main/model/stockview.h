@@ -0,0 +1,24 @@
+#ifndef STOCKVIEW_H
+#define STOCKVIEW_H
+
+#include "constants.h"
+
+/**
+ * @brief The StockView struct indexes one stock out of PatchCollection's interleaved flow
+ *        stocks so that it can be used like any other per-patch array, e.g. p.DOC[i].
+ *
+ *        The view does not own any memory.  PatchCollection points it at the current
+ *        flow buffer and re-points it whenever the buffers are swapped.
+ */
+struct StockView
+{
+    double * base;
+
+    StockView() : base(0) {}
+
+    double & operator[](int i) const {
+        return base[FLOW_STOCKS * i];
+    }
+};
+
+#endif // STOCKVIEW_H
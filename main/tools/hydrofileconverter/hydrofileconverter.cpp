@@ -0,0 +1,23 @@
+#include "../../model/hydrofile.h"
+#include "../../model/riveriofile.h"
+#include <QString>
+#include <iostream>
+
+
+int main(int argc, char *argv[]) {
+
+    if(argc > 3){
+        QString hydroFileName(argv[1]);
+        QString riverIOFileName(argv[2]);
+        QString outputName(argv[3]);
+
+        HydroFile hydroFile(hydroFileName, RiverIOFile(riverIOFileName));
+        if(!hydroFile.writeBinaryFile(outputName)) {
+            std::cerr << "Failed to write " << outputName.toStdString() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+    return 1;
+}
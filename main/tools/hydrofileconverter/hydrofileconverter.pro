@@ -0,0 +1,19 @@
+#Converts text hydromaps to binary hydromaps
+
+TARGET = HydroFileConverter
+DESTDIR = ./
+CONFIG += console c++11
+TEMPLATE = app
+
+QMAKE_CXXFLAGS += -fopenmp
+LIBS += -fopenmp
+
+SOURCES += hydrofileconverter.cpp \
+    ../../model/hydrofile.cpp \
+    ../../model/riveriofile.cpp
+
+HEADERS  += ../../model/hydrofile.h \
+    ../../model/riveriofile.h \
+    ../../model/grid.h \
+
+INCLUDEPATH += ../../model
@@ -2,8 +2,12 @@
 
 TARGET = HydroFileVisualizer
 DESTDIR = ./
-CONFIG += console
+CONFIG += console c++11
 TEMPLATE = app
+
+QMAKE_CXXFLAGS += -fopenmp
+LIBS += -fopenmp
+
 SOURCES += hydrofilevisualizer.cpp \
     ../../model/hydrofile.cpp \
     ../../model/grid.cpp
@@ -21,8 +21,6 @@ QString HydroMaps::parseHydroMapName(QListWidgetItem* item)
 QString HydroMaps::intToHydroFile(int hydro,  const QString & baseDir,
                                   const QVector<int> & minBounds, const QVector<int> & maxBounds)
 {
-    // TODO: make more general
-    QString file("0k-new.txt");
     if (hydro < MIN_HYDRO_DEPTH)
     {
         hydro = MIN_HYDRO_DEPTH;
@@ -32,13 +30,6 @@ QString HydroMaps::intToHydroFile(int hydro,  const QString & baseDir,
         hydro = MAX_HYDRO_DEPTH;
     }
 
-    for (int i = 0; i < minBounds.size() && i < maxBounds.size(); i++)
-    {
-        if (hydro >= minBounds[i] && hydro <= maxBounds[i])
-        {
-            file.prepend(i+1);
-        }
-    }
-
-    return baseDir + QDir::separator() + file;
+    int index = DischargeSchedule::getHydroMapIndex(hydro, minBounds, maxBounds);
+    return DischargeSchedule::getHydroMapFilename(index, baseDir);
 }
@@ -5,6 +5,8 @@
 #include <QDir>
 #include <stdint.h>
 
+#include "../model/dischargeschedule.h"
+
 namespace HydroMaps
 {
     const int MIN_HYDRO_DEPTH = 10000;
@@ -22,6 +24,7 @@ namespace HydroMaps
 
     /**
      * Finds the appropriate hydro file based on the given integer.
+     * Returns an empty string if none of the bounds are valid.
      */
     QString intToHydroFile(int hydro, const QString & baseDir, const QVector<int> & minBounds, const QVector<int> & maxBounds);
 }
@@ -1225,10 +1225,6 @@ bool MainWindow::verifyFile(QLabel* widget, const QString & errorMessage) const
 
 void MainWindow::dischargeToHydro(const QString & file)
 {
-    ifstream fStream;
-    fStream.open(file.toStdString().c_str());
-    string str;
-
     QString hydroMapBasePath(Files::defaultFileLocation());
     hydroMapBasePath.append("/HydroSets");
 
@@ -1237,14 +1233,17 @@ void MainWindow::dischargeToHydro(const QString & file)
                                           Files::defaultFileLocation(), QFileDialog::ShowDirsOnly);
     }
 
-    while (!fStream.eof())
+    DischargeSchedule schedule(file, hydroMapBasePath, getMinFlowBounds(), getMaxFlowBounds());
+    if (schedule.getHydroMaps().isEmpty())
+    {
+        displayErrors("Could not read the discharge file or the flow bounds");
+        return;
+    }
+
+    for (int i = 0; i < schedule.getHydroMaps().size(); i++)
     {
-        std::getline(fStream, str);
-        int hydro = atoi(str.c_str());
-        QString hydroFile = HydroMaps::intToHydroFile(hydro, hydroMapBasePath, getMinFlowBounds(), getMaxFlowBounds());
-        addHydroMap(hydroFile, 1, true, false);
+        addHydroMap(schedule.getHydroMaps()[i], schedule.getDaysToRun()[i], true, false);
     }
-    fStream.close();
 }
 
 void MainWindow::compressHydroFiles()
@@ -9,6 +9,7 @@
 #include "modelthread.h"
 #include "progressthread.h"
 #include "../model/configuration.h"
+#include "../model/dischargeschedule.h"
 #include "../model/rivermodel.h"
 #include "../util/files.h"
 #include "../util/ui.h"
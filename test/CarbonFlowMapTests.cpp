@@ -258,6 +258,116 @@ void CarbonFlowMapTests::testPartialFlow2iter()
     QCOMPARE(totalD, 1.3125);
 }
 
+//Three iterations is not a power of two so it takes both a squaring and a product
+void CarbonFlowMapTests::testPartialFlow3iter()
+{
+    RiverIOFile riverIO("../data/testData/emptyIOTestData.txt");
+    HydroFile file("../data/testData/carbonFlowHydroFile2.txt", riverIO);
+    CarbonFlowMap carbonMap(&file, 3);
+
+    SourceArrays sourceData = carbonMap.getSourceArrays();
+
+    int sourcesOffset;
+    int sourcesSize;
+
+    //How much carbon did A keep?
+    double totalA = 0.0;
+    sourcesOffset = sourceData.getOffset(0,0);
+    sourcesSize = sourceData.getSize(0,0);
+    for(int i = 0; i < sourcesSize; i++) {
+        totalA += sourceData.amount[sourcesOffset + i];
+    }
+    QCOMPARE(totalA, 0.015625);
+
+    //Did carbon go from 0,0 to 1,0, 0,1 and 1,1?
+    int x[3] = {1, 0, 1};
+    int y[3] = {0, 1, 1};
+    for(int cell = 0; cell < 3; cell++) {
+        double total = 0.0;
+        double totalFromA = 0.0;
+        sourcesOffset = sourceData.getOffset(x[cell], y[cell]);
+        sourcesSize = sourceData.getSize(x[cell], y[cell]);
+        for(int i = 0; i < sourcesSize; i++) {
+            total += sourceData.amount[sourcesOffset + i];
+            if(sourceData.x[sourcesOffset + i] == 0 && sourceData.y[sourcesOffset + i] == 0){
+                totalFromA += sourceData.amount[sourcesOffset + i];
+            }
+        }
+        QCOMPARE(totalFromA, 0.328125);
+        QCOMPARE(total, 1.328125);
+    }
+}
+//Keeping half of each cell's carbon leaves B, C and D with only their own carbon and A
+//with only what stayed in it, scaled up to also cover what A sent to B, C and D
+void CarbonFlowMapTests::testAdaptiveTrim()
+{
+    RiverIOFile riverIO("../data/testData/emptyIOTestData.txt");
+    HydroFile file("../data/testData/carbonFlowHydroFile2.txt", riverIO);
+    CarbonFlowMap carbonMap(&file, 3, 0.5);
+
+    SourceArrays sourceData = carbonMap.getSourceArrays();
+
+    int x[4] = {0, 1, 0, 1};
+    int y[4] = {0, 0, 1, 1};
+    for(int cell = 0; cell < 4; cell++) {
+        int sourcesOffset = sourceData.getOffset(x[cell], y[cell]);
+        QCOMPARE(sourceData.getSize(x[cell], y[cell]), 1);
+        QCOMPARE(sourceData.x[sourcesOffset], x[cell]);
+        QCOMPARE(sourceData.y[sourcesOffset], y[cell]);
+        QCOMPARE(sourceData.amount[sourcesOffset], 1.0);
+    }
+
+    QCOMPARE(carbonMap.getTotalMass(), 0.015625 + 3 * 1.328125);
+    QCOMPARE(carbonMap.getTrimmedMass(), 3 * 0.328125);
+    QVERIFY(fabs(carbonMap.getLostMass()) < 1e-12);
+}
+
+namespace {
+    //Adds up where each source's carbon goes, indexed by the source's y * width + x
+    QVector<double> getSourceTotals(const HydroFile & file, const CarbonFlowMap & carbonMap) {
+        SourceArrays sourceData = carbonMap.getSourceArrays();
+        int width = file.getMapWidth();
+        QVector<double> totals(width * file.getMapHeight(), 0.0);
+        for(int x = 0; x < width; x++) {
+            for(int y = 0; y < file.getMapHeight(); y++) {
+                int sourcesOffset = sourceData.getOffset(x, y);
+                for(int i = 0; i < sourceData.getSize(x, y); i++) {
+                    int source = sourceData.y[sourcesOffset + i] * width + sourceData.x[sourcesOffset + i];
+                    totals[source] += sourceData.amount[sourcesOffset + i];
+                }
+            }
+        }
+        return totals;
+    }
+}
+
+//Adaptive trimming keeps every source's carbon, so the carbon left after flowing
+//matches the untrimmed flows whatever each cell starts with
+void CarbonFlowMapTests::testAdaptiveTrimSources()
+{
+    RiverIOFile riverIO("../data/testData/emptyIOTestData.txt");
+    HydroFile file("../data/testData/carbonFlowHydroFile2.txt", riverIO);
+    CarbonFlowMap fullMap(&file, 3);
+    CarbonFlowMap trimmedMap(&file, 3, 0.5);
+
+    QVector<double> fullTotals = getSourceTotals(file, fullMap);
+    QVector<double> trimmedTotals = getSourceTotals(file, trimmedMap);
+    QCOMPARE(trimmedTotals.size(), fullTotals.size());
+    for(int source = 0; source < fullTotals.size(); source++) {
+        QVERIFY(fabs(trimmedTotals[source] - fullTotals[source]) < 1e-12);
+    }
+
+    //A starts with far more carbon than the others
+    double stocks[4] = {8.0, 1.0, 2.0, 3.0};
+    double fullCarbon = 0.0;
+    double trimmedCarbon = 0.0;
+    for(int source = 0; source < fullTotals.size(); source++) {
+        fullCarbon += stocks[source] * fullTotals[source];
+        trimmedCarbon += stocks[source] * trimmedTotals[source];
+    }
+    QCOMPARE(fullCarbon, 14.0);
+    QVERIFY(fabs(trimmedCarbon - fullCarbon) < 1e-12);
+}
 
 void CarbonFlowMapTests::testLandFlow()
 {
@@ -440,4 +550,46 @@ void CarbonFlowMapTests::testRiverIO()
         }
     }
     QCOMPARE(totalD, 1.0);
-}
\ No newline at end of file
+}
+
+//Both grids and every source's x, y and amount are counted
+void CarbonFlowMapTests::testBytes()
+{
+    QCOMPARE(CarbonFlowMap().getBytes(), (size_t)0);
+
+    RiverIOFile riverIO("../data/testData/emptyIOTestData.txt");
+    HydroFile file("../data/testData/carbonFlowHydroFile2.txt", riverIO);
+    CarbonFlowMap carbonMap(&file, 2);
+    SourceArrays sourceData = carbonMap.getSourceArrays();
+
+    size_t gridBytes = 2 * sizeof(int) * file.getMapWidth() * file.getMapHeight();
+    size_t sourceBytes = (2 * sizeof(int) + sizeof(double)) * sourceData.totalSources;
+    QCOMPARE(carbonMap.getBytes(), gridBytes + sourceBytes);
+    QCOMPARE(CarbonFlowMap(carbonMap).getBytes(), carbonMap.getBytes());
+}
+
+void CarbonFlowMapTests::testMove()
+{
+    RiverIOFile riverIO("../data/testData/emptyIOTestData.txt");
+    HydroFile file("../data/testData/carbonFlowHydroFile2.txt", riverIO);
+    CarbonFlowMap carbonMap(&file, 2);
+    SourceArrays sourceData = carbonMap.getSourceArrays();
+    size_t bytes = carbonMap.getBytes();
+
+    //The moved to flow map takes over the arrays and the other is left uninitialized
+    CarbonFlowMap movedMap(std::move(carbonMap));
+    QVERIFY(movedMap.getSourceArrays().amount == sourceData.amount);
+    QCOMPARE(movedMap.getBytes(), bytes);
+    QCOMPARE(carbonMap.getBytes(), (size_t)0);
+    QVERIFY(carbonMap.getSourceArrays().offsets == NULL);
+    QVERIFY(carbonMap.getSourceArrays().sizes == NULL);
+    QVERIFY(carbonMap.getSourceArrays().x == NULL);
+    QVERIFY(carbonMap.getSourceArrays().y == NULL);
+    QVERIFY(carbonMap.getSourceArrays().amount == NULL);
+
+    carbonMap = std::move(movedMap);
+    QVERIFY(carbonMap.getSourceArrays().amount == sourceData.amount);
+    QCOMPARE(carbonMap.getBytes(), bytes);
+    QCOMPARE(movedMap.getBytes(), (size_t)0);
+    QVERIFY(movedMap.getSourceArrays().amount == NULL);
+}
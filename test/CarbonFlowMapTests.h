@@ -14,9 +14,14 @@ class CarbonFlowMapTests : public QObject
     void testFullFlow2iter();
     void testPartialFlow();
     void testPartialFlow2iter();
+    void testPartialFlow3iter();
+    void testAdaptiveTrim();
+    void testAdaptiveTrimSources();
     void testLandFlow();
     void testLandFlow2iter();
     void testRiverIO();
+    void testBytes();
+    void testMove();
 };
 
 #endif
\ No newline at end of file
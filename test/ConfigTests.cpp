@@ -108,6 +108,16 @@ void ConfigTests::configTest()
     config.sedconsumerMax = 95.0;
     config.periAj = 96.0;
     config.periGj = 97.0;
+    config.hourlyFlow = true;
+    config.flowPrecomputeDepth = 7;
+    config.flowTrimMassFraction = 0.99;
+    config.compactFlow = true;
+    config.validateCompactFlow = true;
+    config.flowMemoryBudget = 512;
+    config.dischargeFile = "discharge.txt";
+    config.hydroMapDirectory = "maps";
+    config.saveFluxes = true;
+    config.validatePatchMath = true;
     config.pocInput.append(1.1);
     config.pocInput.append(1.2);
     config.pocInput.append(1.3);
@@ -284,6 +294,16 @@ void ConfigTests::configTest()
     QCOMPARE(config2.sedconsumerMax, 95.0);
     QCOMPARE(config2.periAj, 96.0);
     QCOMPARE(config2.periGj, 97.0);
+    QCOMPARE(config2.hourlyFlow, true);
+    QCOMPARE(config2.flowPrecomputeDepth, 7);
+    QCOMPARE(config2.flowTrimMassFraction, (float)0.99);
+    QCOMPARE(config2.compactFlow, true);
+    QCOMPARE(config2.validateCompactFlow, true);
+    QCOMPARE(config2.flowMemoryBudget, 512);
+    QCOMPARE(config2.dischargeFile, QString("discharge.txt"));
+    QCOMPARE(config2.hydroMapDirectory, QString("maps"));
+    QCOMPARE(config2.saveFluxes, true);
+    QCOMPARE(config2.validatePatchMath, true);
     for (int i = 0; i < 10; i++)
     {
             QCOMPARE(config2.pocInput[i], config.pocInput[i]);
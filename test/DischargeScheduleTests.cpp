@@ -0,0 +1,83 @@
+#include "DischargeScheduleTests.h"
+
+namespace {
+    //The flow ranges of testconfig.conf: 0-14999, 15000-24999, ... 95000-200000
+    void getFlowRanges(QVector<int> & minFlow, QVector<int> & maxFlow) {
+        minFlow.append(0);
+        for(int i = 1; i < 10; i++) {
+            minFlow.append(5000 + 10000 * i);
+            maxFlow.append(4999 + 10000 * i);
+        }
+        maxFlow.append(200000);
+    }
+}
+
+void DischargeScheduleTests::testHydroMapIndex()
+{
+    QVector<int> minFlow, maxFlow;
+    getFlowRanges(minFlow, maxFlow);
+
+    QCOMPARE(DischargeSchedule::getHydroMapIndex(0, minFlow, maxFlow), 0);
+    QCOMPARE(DischargeSchedule::getHydroMapIndex(14999, minFlow, maxFlow), 0);
+    QCOMPARE(DischargeSchedule::getHydroMapIndex(15000, minFlow, maxFlow), 1);
+    QCOMPARE(DischargeSchedule::getHydroMapIndex(62900, minFlow, maxFlow), 5);
+    QCOMPARE(DischargeSchedule::getHydroMapIndex(200000, minFlow, maxFlow), 9);
+
+    //Outside every range the nearest one is used
+    QCOMPARE(DischargeSchedule::getHydroMapIndex(-10, minFlow, maxFlow), 0);
+    QCOMPARE(DischargeSchedule::getHydroMapIndex(14999.8, minFlow, maxFlow), 1);
+    QCOMPARE(DischargeSchedule::getHydroMapIndex(250000, minFlow, maxFlow), 9);
+
+    QCOMPARE(DischargeSchedule::getHydroMapFilename(0, "maps"), QString("maps") + QDir::separator() + "10k-new.txt");
+    QCOMPARE(DischargeSchedule::getHydroMapFilename(9, "maps"), QString("maps") + QDir::separator() + "100k-new.txt");
+}
+
+//Consecutive days on the same hydromap are merged, blank lines are skipped
+void DischargeScheduleTests::testSchedule()
+{
+    QVector<int> minFlow, maxFlow;
+    getFlowRanges(minFlow, maxFlow);
+
+    DischargeSchedule schedule("../data/testData/testDischarge.txt", "maps", minFlow, maxFlow);
+    QCOMPARE(schedule.getDays(), 7);
+    QCOMPARE(schedule.getHydroMaps().size(), 5);
+
+    const char * hydroMaps[5] = {"10k-new.txt", "20k-new.txt", "100k-new.txt", "20k-new.txt", "10k-new.txt"};
+    int days[5] = {2, 2, 1, 1, 1};
+    for(int i = 0; i < 5; i++) {
+        QCOMPARE(schedule.getHydroMaps()[i], QString("maps") + QDir::separator() + hydroMaps[i]);
+        QCOMPARE((int)schedule.getDaysToRun()[i], days[i]);
+    }
+
+    Configuration config;
+    schedule.apply(config);
+    QCOMPARE((int)config.numHydroMaps, 5);
+    QVERIFY(config.hydroMapsSelected == schedule.getHydroMaps());
+    QVERIFY(config.daysToRun == schedule.getDaysToRun());
+}
+
+void DischargeScheduleTests::testNoRanges()
+{
+    QVector<int> minFlow, maxFlow;
+    minFlow.append(100);
+    maxFlow.append(0);
+
+    QCOMPARE(DischargeSchedule::getHydroMapIndex(50, minFlow, maxFlow), -1);
+    QVERIFY(DischargeSchedule::getHydroMapFilename(-1, "maps").isEmpty());
+
+    DischargeSchedule schedule("../data/testData/testDischarge.txt", "maps", minFlow, maxFlow);
+    QCOMPARE(schedule.getDays(), 0);
+    QVERIFY(schedule.getHydroMaps().isEmpty());
+}
+
+//A line that isn't a number rejects the whole file rather than shifting later days
+void DischargeScheduleTests::testBadDischarge()
+{
+    QVector<int> minFlow, maxFlow;
+    getFlowRanges(minFlow, maxFlow);
+
+    DischargeSchedule schedule("../data/testData/testBadDischarge.txt", "maps", minFlow, maxFlow);
+    QCOMPARE(schedule.getDays(), 0);
+    QVERIFY(schedule.getHydroMaps().isEmpty());
+    QVERIFY(schedule.getDaysToRun().isEmpty());
+}
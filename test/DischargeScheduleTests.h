@@ -0,0 +1,20 @@
+#ifndef __DISCHARGESCHEDULETESTS_H__
+#define __DISCHARGESCHEDULETESTS_H__
+
+#include <QtTest/QtTest>
+#include <QString>
+#include <QVector>
+
+#include "dischargeschedule.h"
+
+class DischargeScheduleTests : public QObject
+{
+    Q_OBJECT
+    private slots:
+        void testHydroMapIndex();
+        void testSchedule();
+        void testNoRanges();
+        void testBadDischarge();
+};
+
+#endif
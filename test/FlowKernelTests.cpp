@@ -0,0 +1,104 @@
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include "FlowKernelTests.h"
+
+#define TEST_MAP_WIDTH 16
+#define TEST_MAP_HEIGHT 10
+
+void FlowKernelTests::initTestCase() {
+    //HydroFileDict reads data/inputsoutputs.txt and caches flows in results/cache under the
+    //working directory, so the test runs in a scratch one
+    testDirectory = QDir::currentPath();
+    scratchDirectory = QDir::tempPath() + "/FlowKernelTests";
+    QDir(scratchDirectory).removeRecursively();
+    QDir().mkpath(scratchDirectory + "/data");
+    QVERIFY(QFile::copy(testDirectory + "/../data/testData/emptyIOTestData.txt",
+                        scratchDirectory + "/data/inputsoutputs.txt"));
+    QVERIFY(QDir::setCurrent(scratchDirectory));
+
+    hydroFilename = scratchDirectory + "/flowKernelHydroFile.txt";
+    FILE * file = fopen(hydroFilename.toStdString().c_str(), "w");
+    QVERIFY(file != NULL);
+    fprintf(file, "pxcor pycor depth px-vector py-vector velocity\n");
+    for(int x = 0; x < TEST_MAP_WIDTH; x++) {
+        for(int y = 0; y < TEST_MAP_HEIGHT; y++) {
+            if((2 * x + y) % 9 == 0) {
+                continue;
+            }
+            double depth = 0.3 + 0.29 * ((x * 7 + y * 3) % 13);
+            double velocity = 0.013 * ((x * 11 + y * 5) % 17);
+            fprintf(file, " %d %d %.3f %.4f %.4f %.4f", x, y, depth, 0.8 * velocity, -0.6 * velocity, velocity);
+        }
+    }
+    fprintf(file, "\n");
+    fclose(file);
+}
+
+void FlowKernelTests::cleanupTestCase() {
+    QDir::setCurrent(testDirectory);
+    QDir(scratchDirectory).removeRecursively();
+}
+
+//The selected kernel fuses each multiply and add, so a stock summed over n sources may
+//differ from the scalar kernel by n rounding errors of the sum.  Dry patches are copied.
+void FlowKernelTests::compareKernels(const FlowOperator & flowOperator, const bool * hasWater) {
+    int rows = flowOperator.getRows();
+    QVector<double> source(FLOW_STOCKS * rows);
+    for(int i = 0; i < source.size(); i++) {
+        source[i] = 0.1 + (i * 29 % 23) / 3.0;
+    }
+    QVector<double> scalar(FLOW_STOCKS * rows, -1.0);
+    QVector<double> selected(FLOW_STOCKS * rows, -1.0);
+
+    FlowKernel::transportScalar(flowOperator, hasWater, source.constData(), scalar.data());
+    FlowKernel::TransportFunction transport = FlowKernel::selectTransport();
+    transport(flowOperator, hasWater, source.constData(), selected.data());
+
+    for(int i = 0; i < rows; i++) {
+        int numSources = flowOperator.rowOffsets[i + 1] - flowOperator.rowOffsets[i];
+        for(int stock = 0; stock < FLOW_STOCKS; stock++) {
+            int index = FLOW_STOCKS * i + stock;
+            if(!hasWater[i]) {
+                QVERIFY(scalar[index] == source[index]);
+                QVERIFY(selected[index] == source[index]);
+            } else {
+                QVERIFY(fabs(selected[index] - scalar[index]) <= numSources * DBL_EPSILON * scalar[index]);
+            }
+        }
+    }
+}
+
+void FlowKernelTests::testSelectedMatchesScalar() {
+    Configuration config;
+    config.read(testDirectory + "/../data/testconfig.conf");
+
+    QStringList filenames;
+    filenames.append(hydroFilename);
+    HydroFileDict hydroFileDict(filenames, config);
+    PatchCollection p(config, hydroFileDict);
+
+    HydroData * hydroData = hydroFileDict.waitForFlows(hydroFilename);
+    FlowOperator flowOperator(hydroData->hydroFile, hydroData->carbonFlowMap, p);
+    QVERIFY(flowOperator.getNonZeros() > 2 * flowOperator.getRows());
+
+    //Some patches of the hydromap are dry as well, their rows must be skipped
+    bool * hasWater = new bool[p.getSize()];
+    int dry = 0;
+    for(int i = 0; i < p.getSize(); i++) {
+        hasWater[i] = hydroData->hydroFile.patchExists(p.pxcor[i], p.pycor[i]) && i % 5 != 2;
+        dry += !hasWater[i];
+    }
+    QVERIFY(dry > 0);
+    QVERIFY(dry < p.getSize());
+
+    qDebug("Comparing the %s kernel with the scalar one",
+           FlowKernel::getName(FlowKernel::selectTransport()));
+    compareKernels(flowOperator, hasWater);
+
+    FlowOperator compactOperator(flowOperator);
+    compactOperator.compact();
+    compareKernels(compactOperator, hasWater);
+
+    delete [] hasWater;
+}
@@ -0,0 +1,30 @@
+#ifndef __FLOWKERNELTESTS_H__
+#define __FLOWKERNELTESTS_H__
+
+#include <QtTest/QtTest>
+#include <QString>
+#include <QVector>
+
+#include "configuration.h"
+#include "flowkernel.h"
+#include "flowoperator.h"
+#include "hydrofiledict.h"
+#include "patchcollection.h"
+
+class FlowKernelTests : public QObject
+{
+    Q_OBJECT
+    private:
+        QString testDirectory;
+        QString scratchDirectory;
+        QString hydroFilename;
+
+        void compareKernels(const FlowOperator & flowOperator, const bool * hasWater);
+
+    private slots:
+        void initTestCase();
+        void cleanupTestCase();
+        void testSelectedMatchesScalar();
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include <cstdio>
+#include "FlowMapCacheTests.h"
+
+#define TEST_MAP_WIDTH 10
+#define TEST_MAP_HEIGHT 8
+#define TEST_IO_FILE "../data/testData/emptyIOTestData.txt"
+#define TEST_ITERATIONS 3
+#define TEST_TRIM_FRACTION 0.999
+
+void FlowMapCacheTests::initTestCase() {
+    scratchDirectory = QDir::tempPath() + "/FlowMapCacheTests";
+    cacheDirectory = scratchDirectory + "/cache";
+    QDir(scratchDirectory).removeRecursively();
+    QDir().mkpath(scratchDirectory);
+
+    //The same river with slower water, so only the file contents tell them apart
+    hydroFilename = scratchDirectory + "/flowMapCacheHydroFile.txt";
+    hydroFilename2 = scratchDirectory + "/flowMapCacheHydroFile2.txt";
+    writeHydroFile(hydroFilename, 1.0);
+    writeHydroFile(hydroFilename2, 0.5);
+}
+
+void FlowMapCacheTests::cleanupTestCase() {
+    QDir(scratchDirectory).removeRecursively();
+}
+
+void FlowMapCacheTests::writeHydroFile(const QString & filename, double velocityScale) {
+    FILE * file = fopen(filename.toStdString().c_str(), "w");
+    QVERIFY(file != NULL);
+    fprintf(file, "pxcor pycor depth px-vector py-vector velocity\n");
+    for(int x = 0; x < TEST_MAP_WIDTH; x++) {
+        for(int y = 0; y < TEST_MAP_HEIGHT; y++) {
+            if((x + 3 * y) % 8 == 0) {
+                continue;
+            }
+            double depth = 0.4 + 0.23 * ((x * 5 + y * 3) % 9);
+            double velocity = velocityScale * 0.019 * ((x * 7 + y * 3) % 11);
+            fprintf(file, " %d %d %.3f %.4f %.4f %.4f", x, y, depth, 0.6 * velocity, 0.8 * velocity, velocity);
+        }
+    }
+    fprintf(file, "\n");
+    fclose(file);
+}
+
+//Every cell must pull the very same amounts from the very same patches
+void FlowMapCacheTests::compareFlowMaps(const CarbonFlowMap & cached, const CarbonFlowMap & computed,
+                                        const HydroFile & hydroFile)
+{
+    SourceArrays cachedData = cached.getSourceArrays();
+    SourceArrays computedData = computed.getSourceArrays();
+    QCOMPARE(cachedData.totalSources, computedData.totalSources);
+    QVERIFY(cached.getTotalMass() == computed.getTotalMass());
+    QVERIFY(cached.getTrimmedMass() == computed.getTrimmedMass());
+    QVERIFY(cached.getLostMass() == computed.getLostMass());
+
+    for(int x = 0; x < hydroFile.getMapWidth(); x++) {
+        for(int y = 0; y < hydroFile.getMapHeight(); y++) {
+            if(!hydroFile.patchExists(x,y)) {
+                continue;
+            }
+            QCOMPARE(cachedData.getOffset(x,y), computedData.getOffset(x,y));
+            QCOMPARE(cachedData.getSize(x,y), computedData.getSize(x,y));
+        }
+    }
+    for(int i = 0; i < computedData.totalSources; i++) {
+        QCOMPARE(cachedData.x[i], computedData.x[i]);
+        QCOMPARE(cachedData.y[i], computedData.y[i]);
+        QVERIFY(cachedData.amount[i] == computedData.amount[i]);
+    }
+}
+
+//The first request computes and stores the map, the second maps the stored one
+void FlowMapCacheTests::testFlowMapRoundTrip() {
+    RiverIOFile riverIO(TEST_IO_FILE);
+    HydroFile hydroFile(hydroFilename, riverIO);
+    FlowMapCache cache(cacheDirectory, TEST_IO_FILE);
+
+    QString cacheFilename = cache.getCacheFilename(hydroFilename, TEST_ITERATIONS, TEST_TRIM_FRACTION);
+    QVERIFY(cacheFilename.endsWith(".cfm"));
+    QVERIFY(!QFile::exists(cacheFilename));
+
+    CarbonFlowMap stored;
+    QVERIFY(!cache.getCarbonFlowMap(hydroFilename, &hydroFile, TEST_ITERATIONS, TEST_TRIM_FRACTION, stored));
+    QVERIFY(QFile::exists(cacheFilename));
+
+    CarbonFlowMap loaded;
+    QVERIFY(cache.getCarbonFlowMap(hydroFilename, &hydroFile, TEST_ITERATIONS, TEST_TRIM_FRACTION, loaded));
+
+    CarbonFlowMap computed(&hydroFile, TEST_ITERATIONS, TEST_TRIM_FRACTION);
+    QVERIFY(computed.getSourceArrays().totalSources > hydroFile.getCellCount());
+    compareFlowMaps(stored, computed, hydroFile);
+    compareFlowMaps(loaded, computed, hydroFile);
+}
+
+//A cached hydromap has the same cells as one parsed from the text file
+void FlowMapCacheTests::testHydroFileRoundTrip() {
+    RiverIOFile riverIO(TEST_IO_FILE);
+    FlowMapCache cache(cacheDirectory, TEST_IO_FILE);
+
+    QString cacheFilename = cache.getHydroCacheFilename(hydroFilename);
+    QVERIFY(cacheFilename.endsWith(".hmb"));
+
+    HydroFile stored;
+    QVERIFY(!cache.getHydroFile(hydroFilename, riverIO, stored));
+    QVERIFY(QFile::exists(cacheFilename));
+    HydroFile loaded;
+    QVERIFY(cache.getHydroFile(hydroFilename, riverIO, loaded));
+
+    HydroFile parsed(hydroFilename, riverIO);
+    QCOMPARE(loaded.getMapWidth(), parsed.getMapWidth());
+    QCOMPARE(loaded.getMapHeight(), parsed.getMapHeight());
+    QCOMPARE(loaded.getCellCount(), parsed.getCellCount());
+    for(int i = 0; i < parsed.getMapWidth() * parsed.getMapHeight(); i++) {
+        QCOMPARE(loaded.getCellIndices()[i], parsed.getCellIndices()[i]);
+    }
+    for(int i = 0; i < parsed.getCellCount(); i++) {
+        QCOMPARE(loaded.getCellX()[i], parsed.getCellX()[i]);
+        QCOMPARE(loaded.getCellY()[i], parsed.getCellY()[i]);
+        QVERIFY(loaded.getDepths()[i] == parsed.getDepths()[i]);
+        QVERIFY(loaded.getFlowVectors()[2 * i] == parsed.getFlowVectors()[2 * i]);
+        QVERIFY(loaded.getFlowVectors()[2 * i + 1] == parsed.getFlowVectors()[2 * i + 1]);
+        QVERIFY(loaded.getFileVelocities()[i] == parsed.getFileVelocities()[i]);
+        QCOMPARE(loaded.getIOFlags()[i], parsed.getIOFlags()[i]);
+    }
+}
+
+//Anything the precompute depends on must lead to a different file, and so a miss
+void FlowMapCacheTests::testSettingsChangeKey() {
+    RiverIOFile riverIO(TEST_IO_FILE);
+    HydroFile hydroFile(hydroFilename, riverIO);
+    FlowMapCache cache(cacheDirectory, TEST_IO_FILE);
+    FlowMapCache otherIOCache(cacheDirectory, "../data/testData/ioTestData.txt");
+
+    CarbonFlowMap carbonFlowMap;
+    cache.getCarbonFlowMap(hydroFilename, &hydroFile, TEST_ITERATIONS, TEST_TRIM_FRACTION, carbonFlowMap);
+    QVERIFY(cache.getCarbonFlowMap(hydroFilename, &hydroFile, TEST_ITERATIONS, TEST_TRIM_FRACTION, carbonFlowMap));
+
+    QString cacheFilename = cache.getCacheFilename(hydroFilename, TEST_ITERATIONS, TEST_TRIM_FRACTION);
+    QVERIFY(cache.getCacheFilename(hydroFilename, TEST_ITERATIONS + 1, TEST_TRIM_FRACTION) != cacheFilename);
+    QVERIFY(cache.getCacheFilename(hydroFilename, TEST_ITERATIONS, 0.99) != cacheFilename);
+    QVERIFY(otherIOCache.getCacheFilename(hydroFilename, TEST_ITERATIONS, TEST_TRIM_FRACTION) != cacheFilename);
+    QVERIFY(cache.getCacheFilename(hydroFilename2, TEST_ITERATIONS, TEST_TRIM_FRACTION) != cacheFilename);
+
+    QVERIFY(!cache.getCarbonFlowMap(hydroFilename, &hydroFile, TEST_ITERATIONS + 1, TEST_TRIM_FRACTION, carbonFlowMap));
+    QVERIFY(!cache.getCarbonFlowMap(hydroFilename, &hydroFile, TEST_ITERATIONS, 0.99, carbonFlowMap));
+    QVERIFY(!otherIOCache.getCarbonFlowMap(hydroFilename, &hydroFile, TEST_ITERATIONS, TEST_TRIM_FRACTION, carbonFlowMap));
+
+    //Hydromaps carry the river IO flags, so their key covers the river IO file too
+    QVERIFY(otherIOCache.getHydroCacheFilename(hydroFilename) != cache.getHydroCacheFilename(hydroFilename));
+}
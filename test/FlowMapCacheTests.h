@@ -0,0 +1,33 @@
+#ifndef __FLOWMAPCACHETESTS_H__
+#define __FLOWMAPCACHETESTS_H__
+
+#include <QtTest/QtTest>
+#include <QString>
+
+#include "carbonflowmap.h"
+#include "flowmapcache.h"
+#include "hydrofile.h"
+
+class FlowMapCacheTests : public QObject
+{
+    Q_OBJECT
+    private:
+        QString scratchDirectory;
+        QString cacheDirectory;
+        QString hydroFilename;
+        QString hydroFilename2;
+
+        void writeHydroFile(const QString & filename, double velocityScale);
+
+        void compareFlowMaps(const CarbonFlowMap & cached, const CarbonFlowMap & computed,
+                             const HydroFile & hydroFile);
+
+    private slots:
+        void initTestCase();
+        void cleanupTestCase();
+        void testFlowMapRoundTrip();
+        void testHydroFileRoundTrip();
+        void testSettingsChangeKey();
+};
+
+#endif
@@ -0,0 +1,205 @@
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include "FlowOperatorTests.h"
+
+#define TEST_MAP_WIDTH 12
+#define TEST_MAP_HEIGHT 9
+
+void FlowOperatorTests::initTestCase() {
+    //HydroFileDict reads data/inputsoutputs.txt and caches flows in results/cache under the
+    //working directory, so the test runs in a scratch one
+    testDirectory = QDir::currentPath();
+    scratchDirectory = QDir::tempPath() + "/FlowOperatorTests";
+    QDir(scratchDirectory).removeRecursively();
+    QDir().mkpath(scratchDirectory + "/data");
+    QVERIFY(QFile::copy(testDirectory + "/../data/testData/emptyIOTestData.txt",
+                        scratchDirectory + "/data/inputsoutputs.txt"));
+    QVERIFY(QDir::setCurrent(scratchDirectory));
+
+    //Two hydromaps with different land and flow directions, so each has rows the other lacks
+    hydroFilename = scratchDirectory + "/flowOperatorHydroFile.txt";
+    hydroFilename2 = scratchDirectory + "/flowOperatorHydroFile2.txt";
+    writeHydroFile(hydroFilename, 7, 0.3);
+    writeHydroFile(hydroFilename2, 5, 1.2);
+}
+
+void FlowOperatorTests::cleanupTestCase() {
+    QDir::setCurrent(testDirectory);
+    QDir(scratchDirectory).removeRecursively();
+}
+
+void FlowOperatorTests::writeHydroFile(const QString & filename, int landStep, double flowAngle) {
+    FILE * file = fopen(filename.toStdString().c_str(), "w");
+    QVERIFY(file != NULL);
+    fprintf(file, "pxcor pycor depth px-vector py-vector velocity\n");
+    for(int x = 0; x < TEST_MAP_WIDTH; x++) {
+        for(int y = 0; y < TEST_MAP_HEIGHT; y++) {
+            if((x + 2 * y) % landStep == 0) {
+                continue;
+            }
+            double depth = 0.2 + 0.31 * ((x * 13 + y * 7) % 11);
+            double velocity = (x + y) % 6 == 0 ? 0.0 : 0.017 * ((x * 5 + y * 11) % 13);
+            double angle = flowAngle + 0.1 * ((x * 3 + y) % 5);
+            fprintf(file, " %d %d %.3f %.4f %.4f %.4f", x, y, depth,
+                    cos(angle) * velocity, sin(angle) * velocity, velocity);
+        }
+    }
+    fprintf(file, "\n");
+    fclose(file);
+}
+
+//Pulling a single unit of carbon from one patch gives back what every row takes from it
+void FlowOperatorTests::testUnitStocks() {
+    Configuration config;
+    config.read(testDirectory + "/../data/testconfig.conf");
+
+    QStringList filenames;
+    filenames.append(hydroFilename);
+    filenames.append(hydroFilename2);
+    HydroFileDict hydroFileDict(filenames, config);
+    PatchCollection p(config, hydroFileDict);
+
+    for(int file = 0; file < filenames.size(); file++) {
+        HydroData * hydroData = hydroFileDict.waitForFlows(filenames[file]);
+        FlowOperator flowOperator(hydroData->hydroFile, hydroData->carbonFlowMap, p);
+        SourceArrays sourceData = hydroData->carbonFlowMap.getSourceArrays();
+        QCOMPARE(flowOperator.getRows(), p.getSize());
+
+        int totalSources = 0;
+        for(int i = 0; i < p.getSize(); i++) {
+            if(hydroData->hydroFile.patchExists(p.pxcor[i], p.pycor[i])) {
+                totalSources += sourceData.getSize(p.pxcor[i], p.pycor[i]);
+            }
+        }
+        QCOMPARE(flowOperator.getNonZeros(), totalSources);
+        QVERIFY(totalSources > p.getSize());
+
+        QVector<double> source(p.getSize(), 0.0);
+        QVector<double> dest(p.getSize(), 0.0);
+        for(int j = 0; j < p.getSize(); j++) {
+            source[j] = 1.0;
+            flowOperator.apply(source.data(), dest.data());
+            source[j] = 0.0;
+
+            for(int i = 0; i < p.getSize(); i++) {
+                int x = p.pxcor[i];
+                int y = p.pycor[i];
+                double expected = 0.0;
+                if(hydroData->hydroFile.patchExists(x,y)) {
+                    int offset = sourceData.getOffset(x,y);
+                    for(int s = 0; s < sourceData.getSize(x,y); s++) {
+                        if(sourceData.x[offset + s] == p.pxcor[j] && sourceData.y[offset + s] == p.pycor[j]) {
+                            expected += sourceData.amount[offset + s];
+                        }
+                    }
+                }
+                QVERIFY(dest[i] == expected);
+            }
+        }
+    }
+}
+
+//Composing gives the same flows as applying one operator after the other, except for the
+//entries the trim threshold drops
+void FlowOperatorTests::testMultiply() {
+    Configuration config;
+    config.read(testDirectory + "/../data/testconfig.conf");
+
+    QStringList filenames;
+    filenames.append(hydroFilename);
+    filenames.append(hydroFilename2);
+    HydroFileDict hydroFileDict(filenames, config);
+    PatchCollection p(config, hydroFileDict);
+
+    HydroData * first = hydroFileDict.waitForFlows(hydroFilename);
+    FlowOperator firstOperator(first->hydroFile, first->carbonFlowMap, p);
+    HydroData * second = hydroFileDict.waitForFlows(hydroFilename2);
+    FlowOperator secondOperator(second->hydroFile, second->carbonFlowMap, p);
+
+    QVector<double> source(p.getSize());
+    for(int i = 0; i < p.getSize(); i++) {
+        source[i] = 0.5 + (i * 37 % 19) / 7.0;
+    }
+    QVector<double> halfway(p.getSize());
+    QVector<double> twice(p.getSize());
+    firstOperator.apply(source.data(), halfway.data());
+    secondOperator.apply(halfway.data(), twice.data());
+
+    //Nothing is trimmed, only the order of the additions changes
+    FlowOperator product = secondOperator.multiply(firstOperator, 0.0);
+    QVector<double> composed(p.getSize());
+    product.apply(source.data(), composed.data());
+    for(int i = 0; i < p.getSize(); i++) {
+        QVERIFY(fabs(composed[i] - twice[i]) <= 1e-12 * fabs(twice[i]));
+    }
+
+    //Trimmed entries are dropped, the ones kept are unchanged
+    double trimThreshold = 0.01;
+    FlowOperator trimmed = secondOperator.multiply(firstOperator, trimThreshold);
+    QCOMPARE(trimmed.getRows(), product.getRows());
+    QVERIFY(trimmed.getNonZeros() < product.getNonZeros());
+    for(int i = 0; i < product.getRows(); i++) {
+        int trimmedEntry = trimmed.rowOffsets[i];
+        for(int entry = product.rowOffsets[i]; entry < product.rowOffsets[i + 1]; entry++) {
+            if(trimmedEntry < trimmed.rowOffsets[i + 1] && trimmed.columns[trimmedEntry] == product.columns[entry]) {
+                QVERIFY(trimmed.weights[trimmedEntry] == product.weights[entry]);
+                QVERIFY(trimmed.weights[trimmedEntry] > trimThreshold);
+                trimmedEntry++;
+            } else {
+                QVERIFY(product.weights[entry] <= trimThreshold);
+            }
+        }
+        QCOMPARE(trimmedEntry, trimmed.rowOffsets[i + 1]);
+    }
+}
+
+//Float weights are the double weights rounded once, everything else is kept as is
+void FlowOperatorTests::testCompact() {
+    Configuration config;
+    config.read(testDirectory + "/../data/testconfig.conf");
+
+    QStringList filenames;
+    filenames.append(hydroFilename);
+    HydroFileDict hydroFileDict(filenames, config);
+    PatchCollection p(config, hydroFileDict);
+
+    HydroData * hydroData = hydroFileDict.waitForFlows(hydroFilename);
+    FlowOperator flowOperator(hydroData->hydroFile, hydroData->carbonFlowMap, p);
+    FlowOperator compactOperator(flowOperator);
+    compactOperator.compact();
+
+    QVERIFY(!flowOperator.isCompact());
+    QVERIFY(compactOperator.isCompact());
+    QVERIFY(compactOperator.weights == NULL);
+    QCOMPARE(compactOperator.getNonZeros(), flowOperator.getNonZeros());
+    QCOMPARE(compactOperator.getBytes() + (sizeof(double) - sizeof(float)) * flowOperator.getNonZeros(),
+             flowOperator.getBytes());
+
+    for(int i = 0; i <= flowOperator.getRows(); i++) {
+        QCOMPARE(compactOperator.rowOffsets[i], flowOperator.rowOffsets[i]);
+    }
+    for(int entry = 0; entry < flowOperator.getNonZeros(); entry++) {
+        QCOMPARE(compactOperator.columns[entry], flowOperator.columns[entry]);
+        double weight = flowOperator.weights[entry];
+        QVERIFY(fabs(compactOperator.compactWeights[entry] - weight) <= 0.5 * FLT_EPSILON * weight);
+    }
+
+    //A row of rounded weights moves at most a float's rounding of the carbon it pulls
+    for(int i = 0; i < flowOperator.getRows(); i++) {
+        double sum = 0.0;
+        double compactSum = 0.0;
+        for(int entry = flowOperator.rowOffsets[i]; entry < flowOperator.rowOffsets[i + 1]; entry++) {
+            sum += flowOperator.weights[entry];
+            compactSum += compactOperator.compactWeights[entry];
+        }
+        QVERIFY(fabs(compactSum - sum) <= FLT_EPSILON * sum);
+    }
+
+    //Copies stay compact
+    FlowOperator copy(compactOperator);
+    QVERIFY(copy.isCompact());
+    for(int entry = 0; entry < copy.getNonZeros(); entry++) {
+        QVERIFY(copy.compactWeights[entry] == compactOperator.compactWeights[entry]);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef __FLOWOPERATORTESTS_H__
+#define __FLOWOPERATORTESTS_H__
+
+#include <QtTest/QtTest>
+#include <QString>
+
+#include "configuration.h"
+#include "flowoperator.h"
+#include "hydrofiledict.h"
+#include "patchcollection.h"
+
+class FlowOperatorTests : public QObject
+{
+    Q_OBJECT
+    private:
+        QString testDirectory;
+        QString scratchDirectory;
+        QString hydroFilename;
+        QString hydroFilename2;
+
+        void writeHydroFile(const QString & filename, int landStep, double flowAngle);
+
+    private slots:
+        void initTestCase();
+        void cleanupTestCase();
+        void testUnitStocks();
+        void testMultiply();
+        void testCompact();
+};
+
+#endif
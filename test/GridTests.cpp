@@ -20,4 +20,25 @@ void GridTests::gridTest()
     QCOMPARE(intGrid(1), 2);
     QCOMPARE(intGrid(2), 3);
     QCOMPARE(intGrid(3), 4);
-}
\ No newline at end of file
+}
+
+void GridTests::moveTest()
+{
+    Grid<int> intGrid(2,3);
+    intGrid(1,2) = 5;
+    int * array = intGrid.getArray();
+
+    //Moving hands over the array rather than copying it
+    Grid<int> movedGrid(std::move(intGrid));
+    QVERIFY(movedGrid.getArray() == array);
+    QCOMPARE(movedGrid.getWidth(), (size_t)2);
+    QCOMPARE(movedGrid.getHeight(), (size_t)3);
+    QCOMPARE(movedGrid(1,2), 5);
+    QCOMPARE(intGrid.getArraySize(), (size_t)0);
+
+    Grid<int> assignedGrid(1,1);
+    assignedGrid = std::move(movedGrid);
+    QVERIFY(assignedGrid.getArray() == array);
+    QCOMPARE(assignedGrid(1,2), 5);
+    QCOMPARE(movedGrid.getArraySize(), (size_t)0);
+}
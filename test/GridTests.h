@@ -9,6 +9,7 @@ class GridTests : public QObject
     Q_OBJECT
     private slots:
     void gridTest();
+    void moveTest();
 };
 
 #endif
\ No newline at end of file
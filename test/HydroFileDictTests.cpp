@@ -0,0 +1,108 @@
+#include <algorithm>
+#include "HydroFileDictTests.h"
+
+void HydroFileDictTests::initTestCase() {
+    //HydroFileDict reads data/inputsoutputs.txt and caches flows in results/cache under the
+    //working directory, so the tests run in a scratch one
+    testDirectory = QDir::currentPath();
+    scratchDirectory = QDir::tempPath() + "/HydroFileDictTests";
+    QDir(scratchDirectory).removeRecursively();
+    QDir().mkpath(scratchDirectory + "/data");
+    QVERIFY(QFile::copy(testDirectory + "/../data/testData/emptyIOTestData.txt",
+                        scratchDirectory + "/data/inputsoutputs.txt"));
+    QVERIFY(QDir::setCurrent(scratchDirectory));
+
+    filenames.clear();
+    filenames.append(testDirectory + "/../data/testData/carbonFlowHydroFile.txt");
+    filenames.append(testDirectory + "/../data/testData/carbonFlowHydroFile2.txt");
+    filenames.append(testDirectory + "/../data/testData/carbonFlowHydroFile3.txt");
+}
+
+void HydroFileDictTests::cleanupTestCase() {
+    QDir::setCurrent(testDirectory);
+    QDir(scratchDirectory).removeRecursively();
+}
+
+size_t HydroFileDictTests::getFlowBytes(HydroFileDict & hydroFileDict, int file) {
+    HydroData * hydroData = hydroFileDict[filenames[file]];
+    return hydroData->carbonFlowMap.getBytes() + hydroData->remainderFlowMap.getBytes();
+}
+
+//With room for any two hydromaps' flows, using one releases the least recently used other
+void HydroFileDictTests::testEvictionOrder() {
+    Configuration config;
+    HydroFileDict hydroFileDict(filenames, config);
+    hydroFileDict.waitForFlowLoader();
+
+    size_t totalBytes = 0;
+    size_t smallestBytes = getFlowBytes(hydroFileDict, 0);
+    for(int file = 0; file < filenames.size(); file++) {
+        QVERIFY(hydroFileDict.hasFlows(filenames[file]));
+        totalBytes += getFlowBytes(hydroFileDict, file);
+        smallestBytes = std::min(smallestBytes, getFlowBytes(hydroFileDict, file));
+    }
+    QVERIFY(smallestBytes > 0);
+
+    FlowCacheStats stats = hydroFileDict.getFlowCacheStats();
+    QCOMPARE(stats.residentBytes, totalBytes);
+    QCOMPARE(stats.evictions, 0);
+
+    size_t budget = totalBytes - smallestBytes;
+    hydroFileDict.setFlowMemoryBudget(budget);
+
+    //The files were loaded in order, so the first is the least recently used
+    int used[4] = {2, 0, 2, 1};
+    bool hit[4] = {true, false, true, false};
+    int evicted[4] = {0, 1, -1, 0};
+    int evictions = 0;
+    for(int step = 0; step < 4; step++) {
+        int hits = hydroFileDict.getFlowCacheStats().hits;
+        int misses = hydroFileDict.getFlowCacheStats().misses;
+
+        HydroData * hydroData = hydroFileDict.waitForFlows(filenames[used[step]]);
+        QVERIFY(hydroData == hydroFileDict[filenames[used[step]]]);
+        QVERIFY(hydroFileDict.hasFlows(filenames[used[step]]));
+
+        stats = hydroFileDict.getFlowCacheStats();
+        QCOMPARE(stats.hits, hits + (hit[step] ? 1 : 0));
+        QCOMPARE(stats.misses, misses + (hit[step] ? 0 : 1));
+        if(evicted[step] >= 0) {
+            evictions++;
+            QVERIFY(!hydroFileDict.hasFlows(filenames[evicted[step]]));
+        }
+        QCOMPARE(stats.evictions, evictions);
+        QVERIFY(stats.residentBytes <= budget);
+        QCOMPARE(stats.budgetBytes, budget);
+    }
+
+    QVERIFY(!hydroFileDict.hasFlows(filenames[0]));
+    QVERIFY(hydroFileDict.hasFlows(filenames[1]));
+    QVERIFY(hydroFileDict.hasFlows(filenames[2]));
+}
+
+//Flow operators count against the budget until their owner frees them, even once their
+//hydromap's flows were released and loaded again
+void HydroFileDictTests::testOperatorBytes() {
+    Configuration config;
+    HydroFileDict hydroFileDict(filenames, config);
+    hydroFileDict.waitForFlowLoader();
+
+    const size_t operatorBytes = 1000;
+    HydroData * last = hydroFileDict[filenames[2]];
+    hydroFileDict.setFlowOperatorBytes(last, operatorBytes);
+
+    //Leaves only the first hydromap's flows
+    hydroFileDict.setFlowMemoryBudget(1);
+    hydroFileDict.waitForFlows(filenames[0]);
+    QVERIFY(!hydroFileDict.hasFlows(filenames[2]));
+    QCOMPARE(hydroFileDict.getFlowCacheStats().residentBytes,
+             getFlowBytes(hydroFileDict, 0) + operatorBytes);
+
+    hydroFileDict.waitForFlows(filenames[2]);
+    QVERIFY(!hydroFileDict.hasFlows(filenames[0]));
+    QCOMPARE(hydroFileDict.getFlowCacheStats().residentBytes,
+             getFlowBytes(hydroFileDict, 2) + operatorBytes);
+
+    hydroFileDict.setFlowOperatorBytes(last, 0);
+    QCOMPARE(hydroFileDict.getFlowCacheStats().residentBytes, getFlowBytes(hydroFileDict, 2));
+}
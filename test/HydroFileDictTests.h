@@ -0,0 +1,28 @@
+#ifndef __HYDROFILEDICTTESTS_H__
+#define __HYDROFILEDICTTESTS_H__
+
+#include <QtTest/QtTest>
+#include <QString>
+#include <QStringList>
+
+#include "configuration.h"
+#include "hydrofiledict.h"
+
+class HydroFileDictTests : public QObject
+{
+    Q_OBJECT
+    private:
+        QString testDirectory;
+        QString scratchDirectory;
+        QStringList filenames;
+
+        size_t getFlowBytes(HydroFileDict & hydroFileDict, int file);
+
+    private slots:
+        void initTestCase();
+        void cleanupTestCase();
+        void testEvictionOrder();
+        void testOperatorBytes();
+};
+
+#endif
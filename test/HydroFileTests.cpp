@@ -69,3 +69,142 @@ void HydroFileTests::testIO() {
     QVERIFY(!hydroFile_.isInput(5,5));
     QVERIFY(!hydroFile_.isOutput(5,5));
 }
+
+void HydroFileTests::lineLayoutTest() {
+    //One cell per line, tab separated header and Windows line endings
+    RiverIOFile riverIO("../data/testData/ioTestData2.txt");
+    HydroFile hydroFile;
+    hydroFile.loadFromFile("../data/testData/testHydroFileLines.txt", riverIO);
+
+    QCOMPARE(hydroFile.getMapHeight(), hydroFile_.getMapHeight());
+    QCOMPARE(hydroFile.getMapWidth(), hydroFile_.getMapWidth());
+    for(int i = 1; i <= 5; i++) {
+        QVERIFY(hydroFile.patchExists(i,i));
+        QCOMPARE(hydroFile.getDepth(i,i), hydroFile_.getDepth(i,i));
+        QCOMPARE(hydroFile.getVector(i,i).x(), hydroFile_.getVector(i,i).x());
+        QCOMPARE(hydroFile.getVector(i,i).y(), hydroFile_.getVector(i,i).y());
+        QCOMPARE(hydroFile.getFileVelocity(i,i), hydroFile_.getFileVelocity(i,i));
+        QCOMPARE(hydroFile.isInput(i,i), hydroFile_.isInput(i,i));
+        QCOMPARE(hydroFile.isOutput(i,i), hydroFile_.isOutput(i,i));
+    }
+    QVERIFY(!hydroFile.patchExists(0,0));
+}
+
+void HydroFileTests::chunkedParseTest() {
+    //Large enough to be split between threads, with cells broken over lines so chunks
+    //start part way through a cell
+    const char * separators[4] = {" ", "\t", "\r\n", "\n  "};
+    QByteArray text("x y depth vx vy velocity\n");
+    int width = 200;
+    int height = 300;
+    int separator = 0;
+    for(int x = 0; x < width; x++) {
+        for(int y = 0; y < height; y++) {
+            char cell[128];
+            snprintf(cell, sizeof(cell), "%d%s%d%s%.3f%s%.2f%s%.2f%s0.5%s", x, separators[separator % 4],
+                     y, separators[(separator + 1) % 4], (x * height + y + 1) / 8.0, separators[(separator + 2) % 4],
+                     x / 4.0, separators[(separator + 3) % 4], -y / 4.0, separators[separator % 4],
+                     separators[(separator + 1) % 4]);
+            text.append(cell);
+            separator++;
+        }
+    }
+    QVERIFY(text.size() > 2 * HYDRO_FILE_PARSE_CHUNK_BYTES);
+
+    QFile file("testChunkedHydroFile.txt");
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(text);
+    file.close();
+
+    HydroFile hydroFile;
+    hydroFile.loadFromFile("testChunkedHydroFile.txt", RiverIOFile("../data/testData/emptyIOTestData.txt"));
+    QFile::remove("testChunkedHydroFile.txt");
+
+    QCOMPARE(hydroFile.getMapWidth(), width);
+    QCOMPARE(hydroFile.getMapHeight(), height);
+    QCOMPARE(hydroFile.getCellCount(), width * height);
+    for(int x = 0; x < width; x++) {
+        for(int y = 0; y < height; y++) {
+            QCOMPARE(hydroFile.getDepth(x,y), (x * height + y + 1) / 8.0);
+            QCOMPARE(hydroFile.getVector(x,y).x(), (float)(x / 4.0));
+            QCOMPARE(hydroFile.getVector(x,y).y(), (float)(-y / 4.0));
+            QCOMPARE(hydroFile.getFileVelocity(x,y), 0.5);
+        }
+    }
+}
+
+void HydroFileTests::binaryFileTest() {
+    QVERIFY(hydroFile_.writeBinaryFile("testHydroFile.hmb"));
+
+    //Binary hydromaps keep the inputs and outputs they were converted with
+    HydroFile hydroFile;
+    QVERIFY(hydroFile.mapBinaryFile("testHydroFile.hmb"));
+    QVERIFY(!hydroFile.mapBinaryFile("../data/testData/testHydroFile.txt"));
+
+    //Copies share the mapping, which must outlive the original
+    HydroFile copy;
+    {
+        HydroFile loaded;
+        loaded.loadFromFile("testHydroFile.hmb", RiverIOFile("../data/testData/emptyIOTestData.txt"));
+        copy = loaded;
+    }
+
+    QCOMPARE(hydroFile.getFileName(), hydroFile_.getFileName());
+    QCOMPARE(copy.getFileName(), hydroFile_.getFileName());
+    QCOMPARE(hydroFile.getHydroIndex(), hydroFile_.getHydroIndex());
+    QCOMPARE(hydroFile.getMapHeight(), hydroFile_.getMapHeight());
+    QCOMPARE(hydroFile.getMapWidth(), hydroFile_.getMapWidth());
+    for(int i = 1; i <= 5; i++) {
+        QVERIFY(hydroFile.patchExists(i,i));
+        QCOMPARE(hydroFile.getDepth(i,i), hydroFile_.getDepth(i,i));
+        QCOMPARE(copy.getDepth(i,i), hydroFile_.getDepth(i,i));
+        QCOMPARE(hydroFile.getVector(i,i).x(), hydroFile_.getVector(i,i).x());
+        QCOMPARE(hydroFile.getVector(i,i).y(), hydroFile_.getVector(i,i).y());
+        QCOMPARE(hydroFile.getFileVelocity(i,i), hydroFile_.getFileVelocity(i,i));
+        QCOMPARE(hydroFile.isInput(i,i), hydroFile_.isInput(i,i));
+        QCOMPARE(copy.isOutput(i,i), hydroFile_.isOutput(i,i));
+    }
+    QVERIFY(!hydroFile.patchExists(0,0));
+
+    QFile::remove("testHydroFile.hmb");
+}
+
+void HydroFileTests::cellArraysTest() {
+    QCOMPARE(hydroFile_.getCellCount(), 5);
+    QCOMPARE(hydroFile_.getCellIndex(0,0), -1);
+    QCOMPARE(hydroFile_.getCellIndex(-1,2), -1);
+    QCOMPARE(hydroFile_.getCellIndex(6,6), -1);
+
+    //Cells are numbered by x and then y
+    for(int i = 1; i <= 5; i++) {
+        int cell = hydroFile_.getCellIndex(i,i);
+        QCOMPARE(cell, i - 1);
+        QCOMPARE(hydroFile_.getCellIndices()[i * hydroFile_.getMapWidth() + i], cell);
+        QCOMPARE(hydroFile_.getCellX()[cell], i);
+        QCOMPARE(hydroFile_.getCellY()[cell], i);
+        QCOMPARE(hydroFile_.getDepths()[cell], hydroFile_.getDepth(i,i));
+        QVERIFY(hydroFile_.getFlowVectors()[2 * cell] == hydroFile_.getVector(i,i).x());
+        QVERIFY(hydroFile_.getFlowVectors()[2 * cell + 1] == hydroFile_.getVector(i,i).y());
+        QCOMPARE(hydroFile_.getFileVelocities()[cell], hydroFile_.getFileVelocity(i,i));
+        QCOMPARE((hydroFile_.getIOFlags()[cell] & HYDRO_FILE_INPUT) != 0, hydroFile_.isInput(i,i));
+        QCOMPARE((hydroFile_.getIOFlags()[cell] & HYDRO_FILE_OUTPUT) != 0, hydroFile_.isOutput(i,i));
+    }
+}
+
+void HydroFileTests::moveTest() {
+    HydroFile hydroFile(hydroFile_);
+    const double * depths = hydroFile.getDepths();
+
+    //The moved to hydromap keeps the same cell arrays and the other is left unloaded
+    HydroFile movedFile(std::move(hydroFile));
+    QVERIFY(movedFile.getDepths() == depths);
+    QCOMPARE(movedFile.getCellCount(), hydroFile_.getCellCount());
+    QCOMPARE(movedFile.getMapWidth(), hydroFile_.getMapWidth());
+    QCOMPARE(movedFile.getDepth(1,1), hydroFile_.getDepth(1,1));
+    QCOMPARE(hydroFile.getCellCount(), 0);
+
+    hydroFile = std::move(movedFile);
+    QVERIFY(hydroFile.getDepths() == depths);
+    QCOMPARE(hydroFile.getCellCount(), hydroFile_.getCellCount());
+    QCOMPARE(movedFile.getCellCount(), 0);
+}
@@ -20,6 +20,11 @@ class HydroFileTests : public QObject
     void vectorTest();
     void velocityTest();
     void testIO();
+    void lineLayoutTest();
+    void chunkedParseTest();
+    void binaryFileTest();
+    void cellArraysTest();
+    void moveTest();
 
 };
 
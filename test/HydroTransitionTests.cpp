@@ -0,0 +1,93 @@
+#include "HydroTransitionTests.h"
+
+/**
+ * The diagonal hydromap has water from (1,1) to (5,5), the square one from (0,0) to (1,1),
+ * so they only share (1,1).  (1,1) and (2,2) are river inputs.
+ */
+void HydroTransitionTests::initTestCase() {
+    RiverIOFile riverIO("../data/testData/ioTestData2.txt");
+    diagonalHydroFile.loadFromFile("../data/testData/testHydroFile.txt", riverIO);
+    squareHydroFile.loadFromFile("../data/testData/carbonFlowHydroFile.txt", riverIO);
+
+    QVector<const HydroFile *> hydroFiles;
+    hydroFiles.append(&diagonalHydroFile);
+    hydroFiles.append(&squareHydroFile);
+    geometry = HydroGeometry(6, 6, hydroFiles);
+}
+
+//Every water cell of either hydromap has a patch, numbered by x and then y
+void HydroTransitionTests::testGeometry() {
+    QCOMPARE(geometry.getSize(), 8);
+    QCOMPARE(geometry.getIndex(0,0), 0);
+    QCOMPARE(geometry.getIndex(0,1), 1);
+    QCOMPARE(geometry.getIndex(1,0), 2);
+    QCOMPARE(geometry.getIndex(1,1), 3);
+    QCOMPARE(geometry.getIndex(5,5), 7);
+    QCOMPARE(geometry.getIndex(2,3), -1);
+    QCOMPARE(geometry.getIndex(-1,0), -1);
+    QCOMPARE(geometry.getIndex(6,6), -1);
+
+    const HydroFile * hydroFiles[2] = {&diagonalHydroFile, &squareHydroFile};
+    for(int file = 0; file < 2; file++) {
+        const HydroFile * hydroFile = hydroFiles[file];
+        for(int cell = 0; cell < hydroFile->getCellCount(); cell++) {
+            int x = hydroFile->getCellX()[cell];
+            int y = hydroFile->getCellY()[cell];
+            int index = geometry.getIndex(x,y);
+            QVERIFY(index >= 0);
+            QCOMPARE(geometry.getPatchX()[index], x);
+            QCOMPARE(geometry.getPatchY()[index], y);
+        }
+    }
+
+    for(int i = 0; i < geometry.getSize(); i++) {
+        int x = geometry.getPatchX()[i];
+        int y = geometry.getPatchY()[i];
+        QCOMPARE(geometry.getIndex(x,y), i);
+        QVERIFY(diagonalHydroFile.patchExists(x,y) || squareHydroFile.patchExists(x,y));
+        if(i > 0) {
+            QVERIFY(x * 6 + y > geometry.getPatchX()[i - 1] * 6 + geometry.getPatchY()[i - 1]);
+        }
+    }
+}
+
+void HydroTransitionTests::testDryingAndWetting() {
+    PatchHydroData diagonal(diagonalHydroFile, geometry);
+    PatchHydroData square(squareHydroFile, geometry);
+
+    QVector<int> diagonalOnly;
+    diagonalOnly << geometry.getIndex(2,2) << geometry.getIndex(3,3)
+                 << geometry.getIndex(4,4) << geometry.getIndex(5,5);
+    QVector<int> squareOnly;
+    squareOnly << geometry.getIndex(0,0) << geometry.getIndex(0,1) << geometry.getIndex(1,0);
+
+    HydroTransition toSquare(diagonal, square);
+    QVERIFY(toSquare.dryingPatches == diagonalOnly);
+    QVERIFY(toSquare.wettingPatches == squareOnly);
+
+    HydroTransition toDiagonal(square, diagonal);
+    QVERIFY(toDiagonal.dryingPatches == squareOnly);
+    QVERIFY(toDiagonal.wettingPatches == diagonalOnly);
+
+    HydroTransition same(square, square);
+    QVERIFY(same.dryingPatches.isEmpty());
+    QVERIFY(same.wettingPatches.isEmpty());
+}
+
+//Inputs outside a hydromap's water are not inputs of that hydromap
+void HydroTransitionTests::testInputPatches() {
+    PatchHydroData diagonal(diagonalHydroFile, geometry);
+    PatchHydroData square(squareHydroFile, geometry);
+
+    QVector<int> diagonalInputs;
+    diagonalInputs << geometry.getIndex(1,1) << geometry.getIndex(2,2);
+    QVector<int> squareInputs;
+    squareInputs << geometry.getIndex(1,1);
+
+    QVERIFY(diagonal.inputPatches == diagonalInputs);
+    QVERIFY(square.inputPatches == squareInputs);
+    for(int i = 0; i < geometry.getSize(); i++) {
+        QCOMPARE((bool)diagonal.isInput[i], diagonalInputs.contains(i));
+        QCOMPARE((bool)square.isInput[i], squareInputs.contains(i));
+    }
+}
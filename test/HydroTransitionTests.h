@@ -0,0 +1,27 @@
+#ifndef __HYDROTRANSITIONTESTS_H__
+#define __HYDROTRANSITIONTESTS_H__
+
+#include <QtTest/QtTest>
+#include <QVector>
+
+#include "hydrofile.h"
+#include "hydrogeometry.h"
+#include "hydrotransition.h"
+#include "patchhydrodata.h"
+
+class HydroTransitionTests : public QObject
+{
+    Q_OBJECT
+    private:
+        HydroFile diagonalHydroFile;
+        HydroFile squareHydroFile;
+        HydroGeometry geometry;
+
+    private slots:
+        void initTestCase();
+        void testGeometry();
+        void testDryingAndWetting();
+        void testInputPatches();
+};
+
+#endif
@@ -0,0 +1,129 @@
+#include <cmath>
+#include <cstdio>
+#include "PatchComputationTests.h"
+
+//Big enough for several PATCH_MATH_BLOCK blocks of water patches
+#define TEST_MAP_WIDTH 40
+#define TEST_MAP_HEIGHT 30
+
+void PatchComputationTests::initTestCase() {
+    //HydroFileDict reads data/inputsoutputs.txt and caches flows in results/cache under the
+    //working directory, so the test runs in a scratch one
+    testDirectory = QDir::currentPath();
+    scratchDirectory = QDir::tempPath() + "/PatchComputationTests";
+    QDir(scratchDirectory).removeRecursively();
+    QDir().mkpath(scratchDirectory + "/data");
+    QVERIFY(QFile::copy(testDirectory + "/../data/testData/emptyIOTestData.txt",
+                        scratchDirectory + "/data/inputsoutputs.txt"));
+    QVERIFY(QDir::setCurrent(scratchDirectory));
+
+    //A hydromap with land cells and every depth and velocity different, some still water
+    hydroFilename = scratchDirectory + "/patchComputationHydroFile.txt";
+    FILE * file = fopen(hydroFilename.toStdString().c_str(), "w");
+    QVERIFY(file != NULL);
+    fprintf(file, "pxcor pycor depth px-vector py-vector velocity\n");
+    for(int x = 0; x < TEST_MAP_WIDTH; x++) {
+        for(int y = 0; y < TEST_MAP_HEIGHT; y++) {
+            if((x + 2 * y) % 7 == 0) {
+                continue;
+            }
+            double depth = 0.1 + 0.37 * ((x * 13 + y * 7) % 23);
+            double velocity = (x + y) % 5 == 0 ? 0.0 : 0.011 * ((x * 5 + y * 11) % 31);
+            fprintf(file, " %d %d %.3f %.4f %.4f %.4f", x, y, depth, 0.6 * velocity, 0.8 * velocity, velocity);
+        }
+    }
+    fprintf(file, "\n");
+    fclose(file);
+}
+
+void PatchComputationTests::cleanupTestCase() {
+    QDir::setCurrent(testDirectory);
+    QDir(scratchDirectory).removeRecursively();
+}
+
+namespace {
+    //Spreads the stocks between a quarter and 1.75 times their initial value
+    double getSeedScale(int patch, int stock) {
+        return 0.25 + 1.5 * ((patch * (2 * stock + 3) + stock * 17) % 97) / 96.0;
+    }
+}
+
+void PatchComputationTests::seedPatches(PatchCollection & p) {
+    for(int i = 0; i < p.getSize(); i++) {
+        p.macro[i] *= getSeedScale(i, 0);
+        p.phyto[i] *= getSeedScale(i, 1);
+        p.herbivore[i] *= getSeedScale(i, 2);
+        p.waterdecomp[i] *= getSeedScale(i, 3);
+        p.seddecomp[i] *= getSeedScale(i, 4);
+        p.sedconsumer[i] *= getSeedScale(i, 5);
+        p.consumer[i] *= getSeedScale(i, 6);
+        p.DOC[i] *= getSeedScale(i, 7);
+        p.POC[i] *= getSeedScale(i, 8);
+        p.detritus[i] *= getSeedScale(i, 9);
+        p.peri[i] *= getSeedScale(i, 10);
+    }
+}
+
+//Every stock and value carried over to the next hour must be the very same double
+void PatchComputationTests::comparePatches(const PatchCollection & reference,
+                                           const PatchCollection & fused)
+{
+    QCOMPARE(fused.getSize(), reference.getSize());
+    for(int i = 0; i < reference.getSize(); i++) {
+        QVERIFY(fused.macro[i] == reference.macro[i]);
+        QVERIFY(fused.phyto[i] == reference.phyto[i]);
+        QVERIFY(fused.herbivore[i] == reference.herbivore[i]);
+        QVERIFY(fused.waterdecomp[i] == reference.waterdecomp[i]);
+        QVERIFY(fused.seddecomp[i] == reference.seddecomp[i]);
+        QVERIFY(fused.sedconsumer[i] == reference.sedconsumer[i]);
+        QVERIFY(fused.consumer[i] == reference.consumer[i]);
+        QVERIFY(fused.DOC[i] == reference.DOC[i]);
+        QVERIFY(fused.POC[i] == reference.POC[i]);
+        QVERIFY(fused.detritus[i] == reference.detritus[i]);
+        QVERIFY(fused.peri[i] == reference.peri[i]);
+        QVERIFY(fused.detritus_POC_transfer[i] == reference.detritus_POC_transfer[i]);
+        QVERIFY(fused.POC_detritus_transfer[i] == reference.POC_detritus_transfer[i]);
+        QVERIFY(fused.macro_death[i] == reference.macro_death[i]);
+    }
+}
+
+//Two days of hourly updates from the same patches, through day and night
+void PatchComputationTests::testFusedMatchesReference() {
+    Configuration config;
+    config.read(testDirectory + "/../data/testconfig.conf");
+    config.saveFluxes = true;
+
+    QStringList filenames;
+    filenames.append(hydroFilename);
+    HydroFileDict hydroFileDict(filenames, config);
+    HydroData * hydroData = hydroFileDict[hydroFilename];
+
+    PatchCollection reference(config, hydroFileDict);
+    QVERIFY(reference.hasFluxes());
+    hydroData->patchHydroData.setTurbidity(PatchComputation::getTurbidity(config));
+    hydroData->patchHydroData.apply(reference);
+    QVERIFY(reference.getActivePatches().size() > 2 * PATCH_MATH_BLOCK);
+    seedPatches(reference);
+
+    PatchCollection fused(reference);
+    comparePatches(reference, fused);
+
+    for(int hour = 0; hour < 48; hour++) {
+        int hourOfDay = hour % 24;
+        int currPAR = 0;
+        if(hourOfDay >= 6 && hourOfDay <= 18) {
+            currPAR = (int)(1800 * sin(M_PI * (hourOfDay - 6) / 12.0));
+        }
+        int currWaterTemp = 12 + hourOfDay / 3;
+        PatchComputation::HourlyForcing forcing =
+                PatchComputation::getHourlyForcing(config, currPAR, currWaterTemp, 0.5);
+
+        #pragma omp parallel
+        {
+            PatchComputation::processPatchesReference(reference, config, forcing);
+            PatchComputation::processPatchesFused(fused, config, forcing);
+        }
+
+        comparePatches(reference, fused);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef __PATCHCOMPUTATIONTESTS_H__
+#define __PATCHCOMPUTATIONTESTS_H__
+
+#include <QtTest/QtTest>
+#include <QString>
+
+#include "configuration.h"
+#include "hydrofiledict.h"
+#include "patchcollection.h"
+#include "patchcomputation.h"
+
+class PatchComputationTests : public QObject
+{
+    Q_OBJECT
+    private:
+        QString testDirectory;
+        QString scratchDirectory;
+        QString hydroFilename;
+
+        void seedPatches(PatchCollection & p);
+        void comparePatches(const PatchCollection & reference, const PatchCollection & fused);
+
+    private slots:
+        void initTestCase();
+        void cleanupTestCase();
+        void testFusedMatchesReference();
+};
+
+#endif
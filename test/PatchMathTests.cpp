@@ -0,0 +1,85 @@
+#include "PatchMathTests.h"
+
+namespace {
+    //Evenly spread values from first to last
+    QVector<double> getRange(double first, double last, int count) {
+        QVector<double> values;
+        for(int i = 0; i < count; i++) {
+            values.append(first + (last - first) * i / (count - 1));
+        }
+        return values;
+    }
+
+    uint64_t getMaxUlp(const QVector<double> & values, double (*function)(double), double (*reference)(double)) {
+        uint64_t maxUlp = 0;
+        for(int i = 0; i < values.size(); i++) {
+            maxUlp = std::max(maxUlp, PatchMath::ulpDistance(function(values[i]), reference(values[i])));
+        }
+        return maxUlp;
+    }
+
+    double libmExp(double x) {
+        return std::exp(x);
+    }
+
+    //libm's log10 is itself up to 2 ulp out, long double gives the correctly rounded result
+    double exactLog10(double x) {
+        return (double)log10l((long double)x);
+    }
+
+    bool sameBits(double a, double b) {
+        return memcmp(&a, &b, sizeof(double)) == 0;
+    }
+}
+
+void PatchMathTests::testExp()
+{
+    QVERIFY(getMaxUlp(getRange(-708.39, 709.78, 200001), PatchMath::exp, libmExp) <= 1);
+    QVERIFY(getMaxUlp(getRange(-2.0, 2.0, 200001), PatchMath::exp, libmExp) <= 1);
+
+    QCOMPARE(PatchMath::exp(0.0), 1.0);
+    QCOMPARE(PatchMath::exp(-800.0), 0.0);
+    QVERIFY(std::isinf(PatchMath::exp(800.0)));
+    QVERIFY(std::isnan(PatchMath::exp(NAN)));
+}
+
+void PatchMathTests::testLog10()
+{
+    QVector<double> powers;
+    for(int i = -300; i <= 300; i++) {
+        powers.append(std::pow(10.0, i));
+        powers.append(std::pow(10.0, i + 0.5));
+    }
+    QVERIFY(getMaxUlp(powers, PatchMath::log10, exactLog10) <= 1);
+
+    //The range the patches' flows give
+    QVERIFY(getMaxUlp(getRange(0.01, 100.0, 200001), PatchMath::log10, exactLog10) <= 1);
+
+    //Just above 1, where the low flow patches' flowTransfer arguments are and log10 is small
+    QVERIFY(getMaxUlp(getRange(1.000000025, 1.05, 2000000), PatchMath::log10, exactLog10) <= 1);
+
+    QCOMPARE(PatchMath::log10(1.0), 0.0);
+    QCOMPARE(PatchMath::log10(1000.0), 3.0);
+    QVERIFY(std::isinf(PatchMath::log10(0.0)));
+    QVERIFY(std::isnan(PatchMath::log10(-1.0)));
+}
+
+//Whichever kernel runs, every value is the same bits as the scalar one, even in place
+void PatchMathTests::testKernels()
+{
+    QVector<double> expArguments = getRange(-750.0, 750.0, 1003);
+    expArguments[10] = NAN;
+    QVector<double> log10Arguments = getRange(-1.0, 1000.0, 1003);
+    log10Arguments[20] = 1e-310;
+
+    PatchMath::Kernels kernels = PatchMath::select();
+    QVector<double> expResults(expArguments.size());
+    QVector<double> log10Results = log10Arguments;
+    kernels.exp(expArguments.constData(), expResults.data(), expResults.size());
+    kernels.log10(log10Results.constData(), log10Results.data(), log10Results.size());
+
+    for(int i = 0; i < expArguments.size(); i++) {
+        QVERIFY(sameBits(expResults[i], PatchMath::exp(expArguments[i])));
+        QVERIFY(sameBits(log10Results[i], PatchMath::log10(log10Arguments[i])));
+    }
+}
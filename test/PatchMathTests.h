@@ -0,0 +1,18 @@
+#ifndef __PATCHMATHTESTS_H__
+#define __PATCHMATHTESTS_H__
+
+#include <QtTest/QtTest>
+#include <QVector>
+
+#include "patchmath.h"
+
+class PatchMathTests : public QObject
+{
+    Q_OBJECT
+    private slots:
+        void testExp();
+        void testLog10();
+        void testKernels();
+};
+
+#endif
@@ -7,6 +7,14 @@
 #include "CarbonFlowMapTests.h"
 #include "CarbonSourceCollectionTests.h"
 #include "RiverIOFileTests.h"
+#include "DischargeScheduleTests.h"
+#include "PatchMathTests.h"
+#include "HydroFileDictTests.h"
+#include "PatchComputationTests.h"
+#include "FlowOperatorTests.h"
+#include "FlowKernelTests.h"
+#include "FlowMapCacheTests.h"
+#include "HydroTransitionTests.h"
 
 int main(int argc, char *argv[])
 {
@@ -18,6 +26,14 @@ int main(int argc, char *argv[])
     StatusTests st;
     CarbonFlowMapTests cft;
 	CarbonSourceCollectionTests csct;
+    DischargeScheduleTests dst;
+    PatchMathTests pmt;
+    HydroFileDictTests hfdt;
+    PatchComputationTests pct;
+    FlowOperatorTests fot;
+    FlowKernelTests fkt;
+    FlowMapCacheTests fmct;
+    HydroTransitionTests htt;
     return
         QTest::qExec(&gt, argc, argv) ||
         QTest::qExec(&rgt, argc, argv) ||
@@ -26,6 +42,14 @@ int main(int argc, char *argv[])
         QTest::qExec(&hft, argc, argv) ||
 		QTest::qExec(&cft, argc, argv) ||
         QTest::qExec(&st, argc, argv) ||
-        QTest::qExec(&csct, argc, argv)
+        QTest::qExec(&csct, argc, argv) ||
+        QTest::qExec(&dst, argc, argv) ||
+        QTest::qExec(&pmt, argc, argv) ||
+        QTest::qExec(&hfdt, argc, argv) ||
+        QTest::qExec(&pct, argc, argv) ||
+        QTest::qExec(&fot, argc, argv) ||
+        QTest::qExec(&fkt, argc, argv) ||
+        QTest::qExec(&fmct, argc, argv) ||
+        QTest::qExec(&htt, argc, argv)
 		;
 }
@@ -1,6 +1,8 @@
 QT+= testlib
 
-CONFIG += testcase debug
+CONFIG += testcase debug c++11
+QMAKE_CXXFLAGS += -fopenmp
+LIBS += -fopenmp
 
 TARGET = runTests
 
@@ -8,10 +10,22 @@ DEPENDPATH += . \
               ../main \
 
 SOURCES +=  ../main/model/configuration.cpp \
+            ../main/model/dischargeschedule.cpp \
+            ../main/model/patchmath.cpp \
             ../main/model/hydrofile.cpp \
             ../main/model/status.cpp \
             ../main/model/carbonsources.cpp \
             ../main/model/carbonflowmap.cpp \
+            ../main/model/flowmapcache.cpp \
+            ../main/model/flowkernel.cpp \
+            ../main/model/flowoperator.cpp \
+            ../main/model/hydrogeometry.cpp \
+            ../main/model/hydrofiledict.cpp \
+            ../main/model/hydrotransition.cpp \
+            ../main/model/patchcollection.cpp \
+            ../main/model/patchcomputation.cpp \
+            ../main/model/patchhydrodata.cpp \
+            ../main/model/utility.cpp \
 			../main/model/RiverIOFile.cpp \
 
 INCLUDEPATH += ../main/model
@@ -28,6 +42,14 @@ HEADERS +=  GridTests.h \
             carbonflowmap.h \
 			RiverIOFile.h \
 			RiverIOFileTests.h \
+            DischargeScheduleTests.h \
+            PatchMathTests.h \
+            HydroFileDictTests.h \
+            PatchComputationTests.h \
+            FlowOperatorTests.h \
+            FlowKernelTests.h \
+            FlowMapCacheTests.h \
+            HydroTransitionTests.h \
 
 SOURCES +=  TestMain.cpp \
             GridTests.cpp \
@@ -38,3 +60,11 @@ SOURCES +=  TestMain.cpp \
             CarbonFlowMapTests.cpp \
             CarbonSourceCollectionTests.cpp \
 			RiverIOFileTests.cpp \
+            DischargeScheduleTests.cpp \
+            PatchMathTests.cpp \
+            HydroFileDictTests.cpp \
+            PatchComputationTests.cpp \
+            FlowOperatorTests.cpp \
+            FlowKernelTests.cpp \
+            FlowMapCacheTests.cpp \
+            HydroTransitionTests.cpp \